@@ -27,8 +27,35 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BUILDER_HAS_MMAP 1
+#else
+#define BUILDER_HAS_MMAP 0
+#endif
 
 /**
  * 建造者模式的用途：
@@ -62,7 +89,23 @@
  *    - 提供 `get_result` 方法返回最终构造的产品. 
  * 4. `Director`：
  *    - 持有建造者的引用, 通过调用其方法控制产品的构建过程. 
- * 5. 主函数：
+ * 5. `ReusableBuilder_A`：
+ *    - 可复用的建造者, `reset` 清空部件但保留字符串容量, 
+ *      既可以构建到内部产品, 也可以通过 `build_into` 构建到调用方提供的产品中, 
+ *      预热后循环构建不再产生堆分配. 
+ * 6. `FlatBuilder` 与 `FlatProductView`：
+ *    - 建造者把部件直接写入一块连续的扁平缓冲区(长度前缀布局, 只含相对偏移), 
+ *      末尾的偏移索引表让只读视图按下标直接定位部件, 
+ *      缓冲区可以直接写入文件、mmap 或放入共享内存, 
+ *      只读视图无需反序列化即可访问各部件. 
+ * 7. `ParallelDirector`：
+ *    - 为每个线程复制一份建造者原型, 把产品区间切分给常驻的工作线程, 
+ *      各线程直接构建到预先分配好的输出数组的不同元素中, 无需加锁. 
+ * 8. `IncrementalBuilder_A`：
+ *    - 记录每个部件依赖哪些输入, 输入变化时只重新计算受影响的部件, 
+ *      未变化的部件通过 `SharedProduct` 与上一次的结果共享, 并统计每次重建
+ *      重新计算的部件数. 
+ * 9. 主函数：
  *    - 创建建造者和指挥者, 通过指挥者调用建造者完成产品的构造. 
  *
  * 优势：
@@ -80,6 +123,32 @@
  * - 希望通过分步构造的方式简化代码逻辑. 
  */
 
+// 统计全局堆分配次数, 用于验证复用建造者在预热后不再分配
+static std::atomic<std::size_t> g_heap_allocs{ 0 };
+
+// 替换的 new/delete 保持为独立函数, 内联后 GCC 会误报 -Wmismatched-new-delete
+#if defined(__GNUC__) || defined(__clang__)
+#define ALLOC_COUNT_NOINLINE __attribute__((noinline))
+#else
+#define ALLOC_COUNT_NOINLINE
+#endif
+
+ALLOC_COUNT_NOINLINE void* operator new(std::size_t size) {
+    g_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+ALLOC_COUNT_NOINLINE void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+ALLOC_COUNT_NOINLINE void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
 // 产品类
 class Product {
 private:
@@ -93,6 +162,27 @@ public:
     void set_part_2(const std::string& part_2) {
         this->part_2 = part_2;
     }
+
+    const std::string& get_part_1() const {
+        return part_1;
+    }
+    const std::string& get_part_2() const {
+        return part_2;
+    }
+
+    // 直接写入部件缓冲区, 已有容量足够时不会重新分配
+    std::string& mutable_part_1() {
+        return part_1;
+    }
+    std::string& mutable_part_2() {
+        return part_2;
+    }
+
+    // 清空部件, 保留容量
+    void clear() {
+        part_1.clear();
+        part_2.clear();
+    }
     void show() const {
         std::cout << "Product: " << part_1 << " " << part_2 << std::endl;
     }
@@ -125,6 +215,390 @@ public:
     }
 };
 
+// 可复用的建造者类: 部件由前缀和标签拼接而成, 写入已保留容量的缓冲区
+class ReusableBuilder_A : public Builder {
+private:
+    static constexpr std::string_view kPart1 = "part_1_";
+    static constexpr std::string_view kPart2 = "part_2_";
+
+    Product product_;
+    std::string label_ = "A";
+
+    // 把部件写入 target, 不保存指向目标的指针, 建造者可以安全地复制和移动
+    void build_to(Product& target) const {
+        std::string& part_1 = target.mutable_part_1();
+        part_1.assign(kPart1.data(), kPart1.size());
+        part_1.append(label_);
+        std::string& part_2 = target.mutable_part_2();
+        part_2.assign(kPart2.data(), kPart2.size());
+        part_2.append(label_);
+    }
+
+public:
+    // 设置下一次构建使用的标签, 复用已有容量
+    void set_label(std::string_view label) {
+        label_.assign(label.data(), label.size());
+    }
+
+    // 清空上一次的结果, 字符串容量保留给下一次构建
+    void reset() {
+        product_.clear();
+    }
+
+    void build_part() override {
+        build_to(product_);
+    }
+
+    // 构建到调用方提供的产品中, 复用其缓冲区
+    void build_into(Product& product) {
+        build_to(product);
+    }
+
+    // 不转移所有权地访问内部产品, 下一次 reset() 前有效
+    const Product& result() const {
+        return product_;
+    }
+
+    // 与调用方的产品交换缓冲区: 调用方得到结果, 建造者回收其旧缓冲区
+    void take_result(Product& out) {
+        std::swap(out, product_);
+    }
+
+    // 兼容 Builder 接口, 返回结果的副本
+    std::unique_ptr<Product> get_result() override {
+        return std::make_unique<Product>(product_);
+    }
+};
+
+// 扁平产品布局(小端序, 不含指针, 与加载地址无关):
+//   [magic u32][version u16][part_count u16][total_size u32]
+//   part_count 个 [length u32][bytes...]
+//   part_count 个 [offset u32] 索引表, 位于缓冲区末尾, 按下标 O(1) 定位部件
+namespace flat {
+constexpr std::uint32_t kMagic = 0x54444F50; // "PODT"
+constexpr std::uint16_t kVersion = 2;
+constexpr std::size_t kHeaderSize = 12;
+constexpr std::size_t kMaxParts = 0xFFFF;
+constexpr std::size_t kMaxSize = 0xFFFFFFFF;
+
+inline void put_u32(char* p, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+inline void put_u16(char* p, std::uint16_t v) {
+    p[0] = static_cast<char>(v & 0xFF);
+    p[1] = static_cast<char>(v >> 8);
+}
+
+inline std::uint32_t get_u32(const char* p) {
+    std::uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) {
+        v |= static_cast<std::uint32_t>(static_cast<unsigned char>(p[i]))
+             << (8 * i);
+    }
+    return v;
+}
+
+inline std::uint16_t get_u16(const char* p) {
+    return static_cast<std::uint16_t>(static_cast<unsigned char>(p[0]) |
+                                      static_cast<unsigned char>(p[1]) << 8);
+}
+}
+
+// 扁平产品的只读视图, 直接引用缓冲区, 不复制任何部件
+class FlatProductView {
+private:
+    const char* data_ = nullptr;
+    const char* index_ = nullptr; // 末尾的偏移索引表
+    std::size_t size_ = 0;
+    std::uint16_t count_ = 0;
+
+public:
+    FlatProductView() = default;
+
+    // 校验缓冲区, 格式不合法时得到空视图(valid() 为 false)
+    FlatProductView(const void* data, std::size_t size) {
+        const char* p = static_cast<const char*>(data);
+        if (size < flat::kHeaderSize || flat::get_u32(p) != flat::kMagic ||
+            flat::get_u16(p + 4) != flat::kVersion ||
+            flat::get_u32(p + 8) > size) {
+            return;
+        }
+        std::size_t total = flat::get_u32(p + 8);
+        std::uint16_t count = flat::get_u16(p + 6);
+        if (total < flat::kHeaderSize + 4 * std::size_t{ count }) {
+            return;
+        }
+        std::size_t index = total - 4 * std::size_t{ count };
+        for (std::uint16_t i = 0; i < count; ++i) {
+            std::size_t offset = flat::get_u32(p + index + 4 * i);
+            if (offset < flat::kHeaderSize || offset + 4 > index ||
+                flat::get_u32(p + offset) > index - offset - 4) {
+                return;
+            }
+        }
+        data_ = p;
+        index_ = p + index;
+        size_ = total;
+        count_ = count;
+    }
+
+    bool valid() const {
+        return data_ != nullptr;
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    std::size_t part_count() const {
+        return count_;
+    }
+
+    // 第 i 个部件, 越界时返回空串
+    std::string_view part(std::size_t i) const {
+        if (i >= count_) {
+            return {};
+        }
+        std::size_t offset = flat::get_u32(index_ + 4 * i);
+        return std::string_view(data_ + offset + 4,
+                                flat::get_u32(data_ + offset));
+    }
+
+    void show() const {
+        std::cout << "FlatProduct:";
+        for (std::size_t i = 0; i < count_; ++i) {
+            std::cout << " " << part(i);
+        }
+        std::cout << std::endl;
+    }
+};
+
+// 扁平建造者: 部件直接追加到同一块缓冲区, 缓冲区在多次构建间复用.
+// 索引表在 buffer()/view() 时才写到末尾, 追加部件不需要移动已有数据.
+class FlatBuilder : public Builder {
+private:
+    std::vector<char> buffer_;
+    std::vector<std::uint32_t> offsets_;
+    std::size_t parts_end_ = 0; // 最后一个部件之后的位置, 索引表从这里开始
+
+    void finish() {
+        if (buffer_.size() != parts_end_) {
+            return;
+        }
+        buffer_.resize(parts_end_ + 4 * offsets_.size());
+        char* index = buffer_.data() + parts_end_;
+        for (std::size_t i = 0; i < offsets_.size(); ++i) {
+            flat::put_u32(index + 4 * i, offsets_[i]);
+        }
+        flat::put_u16(buffer_.data() + 6,
+                      static_cast<std::uint16_t>(offsets_.size()));
+        flat::put_u32(buffer_.data() + 8,
+                      static_cast<std::uint32_t>(buffer_.size()));
+    }
+
+public:
+    FlatBuilder() {
+        reset();
+    }
+
+    // 开始新的产品, 保留缓冲区容量
+    void reset() {
+        buffer_.resize(flat::kHeaderSize);
+        flat::put_u32(buffer_.data(), flat::kMagic);
+        flat::put_u16(buffer_.data() + 4, flat::kVersion);
+        offsets_.clear();
+        parts_end_ = flat::kHeaderSize;
+    }
+
+    // 部件数或总长度超出布局的 u16/u32 字段时抛出 std::length_error
+    void add_part(std::string_view part) {
+        std::size_t end = parts_end_ + 4 + part.size();
+        if (offsets_.size() == flat::kMaxParts ||
+            part.size() > flat::kMaxSize ||
+            end + 4 * (offsets_.size() + 1) > flat::kMaxSize) {
+            throw std::length_error("flat product too large");
+        }
+        buffer_.resize(end);
+        flat::put_u32(buffer_.data() + parts_end_,
+                      static_cast<std::uint32_t>(part.size()));
+        std::memcpy(buffer_.data() + parts_end_ + 4, part.data(), part.size());
+        offsets_.push_back(static_cast<std::uint32_t>(parts_end_));
+        parts_end_ = end;
+    }
+
+    void build_part() override {
+        add_part("part_1_A");
+        add_part("part_2_A");
+    }
+
+    // 序列化结果, 可直接发送、写入文件或复制到共享内存
+    const std::vector<char>& buffer() {
+        finish();
+        return buffer_;
+    }
+
+    FlatProductView view() {
+        finish();
+        return FlatProductView(buffer_.data(), buffer_.size());
+    }
+
+    // 兼容 Builder 接口, 展开为 Product
+    std::unique_ptr<Product> get_result() override {
+        auto product = std::make_unique<Product>();
+        FlatProductView v = view();
+        product->set_part_1(std::string(v.part(0)));
+        product->set_part_2(std::string(v.part(1)));
+        return product;
+    }
+};
+
+#if BUILDER_HAS_MMAP
+// 以只读方式 mmap 一个扁平产品文件, 视图直接引用映射的页面
+class MappedFlatProduct {
+private:
+    void* addr_ = MAP_FAILED;
+    std::size_t length_ = 0;
+
+public:
+    explicit MappedFlatProduct(const char* path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            length_ = static_cast<std::size_t>(st.st_size);
+            addr_ = mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+
+    MappedFlatProduct(const MappedFlatProduct&) = delete;
+    MappedFlatProduct& operator=(const MappedFlatProduct&) = delete;
+
+    ~MappedFlatProduct() {
+        if (addr_ != MAP_FAILED) {
+            munmap(addr_, length_);
+        }
+    }
+
+    FlatProductView view() const {
+        if (addr_ == MAP_FAILED) {
+            return FlatProductView();
+        }
+        return FlatProductView(addr_, length_);
+    }
+};
+#endif
+
+// 部件不可变且可共享的产品快照, 复制快照只增加引用计数
+class SharedProduct {
+private:
+    std::shared_ptr<const std::string> part_1;
+    std::shared_ptr<const std::string> part_2;
+
+    friend class IncrementalBuilder_A;
+
+    // 默认构造或尚未构建的部件视为空串
+    static const std::string& or_empty(
+        const std::shared_ptr<const std::string>& part) {
+        static const std::string empty;
+        return part ? *part : empty;
+    }
+
+public:
+    const std::string& get_part_1() const {
+        return or_empty(part_1);
+    }
+    const std::string& get_part_2() const {
+        return or_empty(part_2);
+    }
+
+    // 两个快照的部件是否为同一对象
+    bool shares_part_1(const SharedProduct& other) const {
+        return part_1 == other.part_1;
+    }
+    bool shares_part_2(const SharedProduct& other) const {
+        return part_2 == other.part_2;
+    }
+
+    void show() const {
+        std::cout << "Product: " << get_part_1() << " " << get_part_2()
+                  << std::endl;
+    }
+};
+
+// 增量建造者: part_1 依赖 label, part_2 依赖 label 和 variant.
+// 输入变化时只标记依赖它的部件为脏, 重建只重新计算脏部件,
+// 其余部件沿用上一次的共享对象.
+class IncrementalBuilder_A : public Builder {
+private:
+    enum Input : unsigned
+    {
+        kLabel = 1u << 0,
+        kVariant = 1u << 1,
+    };
+
+    static constexpr unsigned kPart1Inputs = kLabel;
+    static constexpr unsigned kPart2Inputs = kLabel | kVariant;
+
+    std::string label_ = "A";
+    std::string variant_ = "v1";
+    unsigned changed_ = kLabel | kVariant; // 自上次构建以来变化的输入
+    SharedProduct product_;
+    std::size_t recomputed_ = 0;
+
+public:
+    void set_label(std::string_view label) {
+        if (label != label_) {
+            label_.assign(label.data(), label.size());
+            changed_ |= kLabel;
+        }
+    }
+
+    void set_variant(std::string_view variant) {
+        if (variant != variant_) {
+            variant_.assign(variant.data(), variant.size());
+            changed_ |= kVariant;
+        }
+    }
+
+    void build_part() override {
+        recomputed_ = 0;
+        if (changed_ & kPart1Inputs) {
+            product_.part_1 =
+                std::make_shared<const std::string>("part_1_" + label_);
+            ++recomputed_;
+        }
+        if (changed_ & kPart2Inputs) {
+            product_.part_2 = std::make_shared<const std::string>(
+                "part_2_" + label_ + "_" + variant_);
+            ++recomputed_;
+        }
+        changed_ = 0;
+    }
+
+    // 最近一次构建重新计算的部件数
+    std::size_t parts_recomputed() const {
+        return recomputed_;
+    }
+
+    // 当前结果的快照, 与之后的重建共享未变化的部件
+    SharedProduct snapshot() const {
+        return product_;
+    }
+
+    std::unique_ptr<Product> get_result() override {
+        auto product = std::make_unique<Product>();
+        product->set_part_1(product_.get_part_1());
+        product->set_part_2(product_.get_part_2());
+        return product;
+    }
+};
+
 // 指挥者类
 class Director {
 private:
@@ -139,6 +613,238 @@ public:
     }
 };
 
+// 常驻的构建工作线程: 线程按需创建后在条件变量上等待任务, 并行指挥者
+// 不再为每次构建创建和回收线程. 同一时刻只执行一个任务, 并发调用排队;
+// 任务内部不能再调用 run. 线程保存在成员中, 创建失败时已启动的线程
+// 仍处于空闲状态, 由析构函数回收.
+class BuildWorkers {
+private:
+    std::mutex run_mutex; // 串行化任务
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::vector<std::thread> threads;
+    void (*invoke)(void*, unsigned) = nullptr;
+    void* context = nullptr;
+    std::uint64_t generation = 0;
+    unsigned wanted = 0; // 本次任务使用的工作线程数(不含调用线程)
+    unsigned active = 0; // 尚未完成本次任务的工作线程数
+    bool stopping = false;
+
+    void loop(unsigned index) {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] {
+                return stopping || (generation != seen && index < wanted);
+            });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            void (*task)(void*, unsigned) = invoke;
+            void* ctx = context;
+            lock.unlock();
+            task(ctx, index + 1);
+            lock.lock();
+            if (--active == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+public:
+    BuildWorkers() = default;
+    BuildWorkers(const BuildWorkers&) = delete;
+    BuildWorkers& operator=(const BuildWorkers&) = delete;
+
+    ~BuildWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t: threads) {
+            t.join();
+        }
+    }
+
+    static BuildWorkers& instance() {
+        static BuildWorkers workers;
+        return workers;
+    }
+
+    // 调用线程执行 task(ctx, 0), helpers 个工作线程分别执行 task(ctx, 1..),
+    // 全部完成后返回. task 不能抛出异常; 线程创建失败时任务尚未开始,
+    // 异常直接传给调用方
+    void run(unsigned helpers, void (*task)(void*, unsigned), void* ctx) {
+        std::lock_guard<std::mutex> run_lock(run_mutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (threads.size() < helpers) {
+                unsigned index = static_cast<unsigned>(threads.size());
+                threads.emplace_back([this, index] { loop(index); });
+            }
+            invoke = task;
+            context = ctx;
+            wanted = helpers;
+            active = helpers;
+            ++generation;
+        }
+        wake.notify_all();
+        task(ctx, 0);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return active == 0; });
+    }
+};
+
+// 并行指挥者: 每个线程持有建造者原型的副本, 负责输出数组中连续的一段.
+// B 需可复制并提供 build_into(Product&); configure(builder, i) 为第 i 个
+// 产品设置输入. 各线程写入互不重叠的元素, 因此无需加锁.
+// 建造者或 configure 抛出的异常在所有线程结束后由 construct 重新抛出.
+// 工作线程来自常驻的 BuildWorkers, configure 中不能再调用 construct.
+template <class B>
+class ParallelDirector {
+private:
+    const B& prototype_;
+
+public:
+    explicit ParallelDirector(const B& prototype) : prototype_(prototype) {
+    }
+
+    // 构建 out.size() 个产品, threads 为 0 时使用全部硬件线程
+    template <class Configure>
+    void construct(std::vector<Product>& out, Configure configure,
+                   unsigned threads = 0) const {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::size_t n = out.size();
+        threads = static_cast<unsigned>(
+            std::min<std::size_t>(threads, std::max<std::size_t>(n, 1)));
+        std::size_t per_thread = (n + threads - 1) / threads;
+
+        // 每个线程记录自己的异常, 全部线程汇合后重新抛出第一个
+        std::vector<std::exception_ptr> errors(threads);
+        auto work = [&](unsigned t) {
+            std::size_t begin = std::min(n, t * per_thread);
+            std::size_t end = std::min(n, begin + per_thread);
+            try {
+                B builder(prototype_);
+                for (std::size_t i = begin; i < end; ++i) {
+                    configure(builder, i);
+                    builder.build_into(out[i]);
+                }
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        };
+
+        if (threads == 1) {
+            work(0);
+        } else {
+            BuildWorkers::instance().run(
+                threads - 1,
+                [](void* ctx, unsigned t) {
+                    (*static_cast<decltype(work)*>(ctx))(t);
+                },
+                &work);
+        }
+        for (const std::exception_ptr& error: errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+};
+
+// 构建 n 个产品: 每次新建 Builder_A 与复用建造者的分配次数及耗时对比
+void reuse_benchmark(std::size_t n) {
+    std::size_t checksum = 0;
+
+    std::size_t allocs = g_heap_allocs.load();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        Builder_A builder;
+        builder.build_part();
+        std::unique_ptr<Product> product = builder.get_result();
+        checksum += product->get_part_1().size();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    std::cout << "fresh Builder_A:   "
+              << std::chrono::duration<double, std::nano>(stop - start)
+                         .count() /
+                     n
+              << " ns/product, "
+              << static_cast<double>(g_heap_allocs.load() - allocs) / n
+              << " allocs/product" << std::endl;
+
+    // 标签超过短字符串优化长度, 每次构建的部件内容都不同
+    char label[32] = "catalog-item-";
+    ReusableBuilder_A builder;
+    builder.set_label("catalog-item-18446744073709551615");
+    builder.build_part();
+
+    allocs = g_heap_allocs.load();
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        char* end = std::to_chars(label + 13, label + sizeof(label), i).ptr;
+        builder.set_label(std::string_view(label, end - label));
+        builder.reset();
+        builder.build_part();
+        checksum += builder.result().get_part_1().size();
+    }
+    stop = std::chrono::steady_clock::now();
+    std::cout << "ReusableBuilder_A: "
+              << std::chrono::duration<double, std::nano>(stop - start)
+                         .count() /
+                     n
+              << " ns/product, "
+              << static_cast<double>(g_heap_allocs.load() - allocs) / n
+              << " allocs/product" << std::endl;
+    std::cout << "checksum: " << checksum << std::endl;
+}
+
+// 以序号为标签构建 n 个产品: 串行 Director 与 1 到 N 线程并行指挥者的对比
+void parallel_benchmark(std::size_t n) {
+    auto configure = [](ReusableBuilder_A& builder, std::size_t i) {
+        char label[32] = "catalog-item-";
+        char* end = std::to_chars(label + 13, label + sizeof(label), i).ptr;
+        builder.set_label(std::string_view(label, end - label));
+    };
+
+    std::vector<Product> serial(n);
+    ReusableBuilder_A builder;
+    Director director(builder);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        configure(builder, i);
+        builder.reset();
+        director.construct();
+        builder.take_result(serial[i]);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double serial_ms =
+        std::chrono::duration<double, std::milli>(stop - start).count();
+    std::cout << "serial Director: " << serial_ms << " ms" << std::endl;
+
+    ReusableBuilder_A prototype;
+    ParallelDirector<ReusableBuilder_A> parallel(prototype);
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned t = 1; t <= max_threads; ++t) {
+        std::vector<Product> out(n);
+        start = std::chrono::steady_clock::now();
+        parallel.construct(out, configure, t);
+        stop = std::chrono::steady_clock::now();
+        double ms =
+            std::chrono::duration<double, std::milli>(stop - start).count();
+        bool same = out.back().get_part_1() == serial.back().get_part_1();
+        std::cout << "ParallelDirector: " << ms << " ms, " << t
+                  << " threads, speedup " << serial_ms / ms
+                  << (same ? "" : ", MISMATCH") << std::endl;
+    }
+}
+
 int main(int argc, char* argv[]) {
     // 创建建造者和指挥者
     Builder_A builder_a;
@@ -151,5 +857,81 @@ int main(int argc, char* argv[]) {
     std::unique_ptr<Product> product = builder_a.get_result();
     product->show();
 
+    // 复用建造者: 结果构建到调用方提供的产品中
+    ReusableBuilder_A reusable;
+    Director reusable_director(reusable);
+    reusable_director.construct();
+    reusable.result().show();
+
+    Product reused;
+    reusable.reset();
+    reusable.set_label("B");
+    reusable.build_into(reused);
+    reused.show();
+
+    reuse_benchmark(1000000);
+
+    // 并行构建: 输出数组预先分配, 各线程直接写入
+    std::vector<Product> catalog(4);
+    ReusableBuilder_A prototype;
+    ParallelDirector<ReusableBuilder_A> parallel_director(prototype);
+    parallel_director.construct(
+        catalog, [](ReusableBuilder_A& builder, std::size_t i) {
+            builder.set_label(i % 2 ? "odd" : "even");
+        });
+    for (const Product& item: catalog) {
+        item.show();
+    }
+
+    parallel_benchmark(1000000);
+
+    // 增量构建: 只重新计算依赖变化输入的部件
+    IncrementalBuilder_A incremental;
+    Director incremental_director(incremental);
+    incremental_director.construct();
+    SharedProduct first = incremental.snapshot();
+    std::cout << "initial build recomputed " << incremental.parts_recomputed()
+              << " part(s)" << std::endl;
+
+    incremental.set_variant("v2");
+    incremental_director.construct();
+    SharedProduct second = incremental.snapshot();
+    second.show();
+    std::cout << "variant change recomputed "
+              << incremental.parts_recomputed() << " part(s), part_1 "
+              << (second.shares_part_1(first) ? "shared" : "rebuilt")
+              << std::endl;
+
+    incremental.set_label("B");
+    incremental_director.construct();
+    incremental.snapshot().show();
+    std::cout << "label change recomputed " << incremental.parts_recomputed()
+              << " part(s)" << std::endl;
+
+    // 扁平建造者: 结果是一块可直接共享的缓冲区
+    FlatBuilder flat_builder;
+    Director flat_director(flat_builder);
+    flat_director.construct();
+    flat_builder.view().show();
+
+#if BUILDER_HAS_MMAP
+    // 写入临时文件后 mmap 读取, 全程不反序列化
+    std::string path =
+        (std::filesystem::temp_directory_path() / "flat_product_XXXXXX")
+            .string();
+    int fd = mkstemp(path.data());
+    if (fd >= 0) {
+        const std::vector<char>& buffer = flat_builder.buffer();
+        bool written = write(fd, buffer.data(), buffer.size()) ==
+                       static_cast<ssize_t>(buffer.size());
+        close(fd);
+        if (written) {
+            MappedFlatProduct mapped(path.c_str());
+            mapped.view().show();
+        }
+        unlink(path.c_str());
+    }
+#endif
+
     return 0;
 }
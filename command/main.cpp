@@ -27,10 +27,38 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
+#if __has_include(<unistd.h>)
+#include <fcntl.h>
+#include <unistd.h>
+#define COMMAND_HAS_WAL 1
+#else
+#define COMMAND_HAS_WAL 0
+#endif
+
 /**
  * 命令模式的用途：
  * 命令模式(Command
@@ -55,7 +83,19 @@
  * 3. `CommandA`：具体命令类, 绑定多个接收者, 并通过 `execute` 方法调用它们的
  * `action`. 
  * 4. `Invoke`：调用者类, 负责存储命令对象, 并在合适的时机调用命令. 
- * 5. 主函数：
+ * 5. `CommandA::set_fan_out`：让命令在共享线程池上并行执行各接收者的动作, 
+ *    可选择无顺序、按接收者保序或在末尾等待全部完成(屏障). 
+ * 6. `CommandExecutor`：命令执行服务, 生产者把命令放入有界无锁多生产者多消费者
+ *    队列 `MpmcQueue`, 工作线程池取出执行; 队列满时 `try_submit` 失败、`submit`
+ *    等待(背压), 每个命令返回完成 future, 并统计队列深度、等待时间和执行时间. 
+ * 7. `CommandScheduler`：按优先级类别调度命令, 类别内按截止时间最早优先(EDF), 
+ *    每个类别可限制并发数, 等待过久的命令优先执行以防饿死, 并统计各类别的排队延迟分位数. 
+ * 8. `DurableCommandLog`：持久化执行模式, 命令先序列化追加到预写日志,
+ *    多个命令合并为一次 fsync(组提交)后再执行; 启动时从最近的检查点之后重放日志. 
+ *    命令通过 `type_name`/`encode` 序列化, 通过 `CommandCodec` 反序列化. 
+ * 9. `CommandHistory`：撤销/重做历史, 以紧凑的序列化形式把编辑命令存放在
+ *    固定容量的环形缓冲区中, 超出容量时淘汰最旧的记录; 相邻的连续输入会合并为一条. 
+ * 10. 主函数：
  *    - 创建多个接收者, 并将它们绑定到命令. 
  *    - 调用者设置命令对象, 并触发命令执行, 完成对多个接收者的操作. 
  *
@@ -78,11 +118,16 @@
 class Reciever {
 public:
     virtual ~Reciever() = default;
+    virtual const char* name() const = 0;
     virtual void action() const = 0;
 };
 
 class RecieverA : public Reciever {
 public:
+    const char* name() const override {
+        return "RecieverA";
+    }
+
     void action() const override {
         std::cout << "RecieverA::action()" << std::endl;
     }
@@ -90,6 +135,10 @@ public:
 
 class RecieverB : public Reciever {
 public:
+    const char* name() const override {
+        return "RecieverB";
+    }
+
     void action() const override {
         std::cout << "RecieverB::action()" << std::endl;
     }
@@ -97,6 +146,10 @@ public:
 
 class RecieverC : public Reciever {
 public:
+    const char* name() const override {
+        return "RecieverC";
+    }
+
     void action() const override {
         std::cout << "RecieverC::action()" << std::endl;
     }
@@ -110,20 +163,84 @@ protected:
 public:
     virtual ~Command() = default;
     virtual void execute() const = 0;
+
+    // 撤销 execute() 的效果, 重做即再次 execute(); 默认不可撤销
+    virtual void undo() const {
+    }
+
+    // 持久化支持: 可持久化的命令返回非空类型名, 并把参数编码到 out 中
+    virtual std::string type_name() const {
+        return std::string();
+    }
+    virtual void encode(std::string&) const {
+    }
+};
+
+class CommandExecutor;
+
+// 接收者并行执行时的顺序保证.
+// Barrier 模式下接收者抛出的第一个异常由 execute() 重新抛出;
+// None 与 PerReceiver 模式下 execute() 不等待结果, 接收者的异常被丢弃.
+enum class FanOutOrder
+{
+    None,        // 不等待, 同一接收者的多次动作也可能并发
+    PerReceiver, // 不等待, 同一接收者的动作按提交顺序依次执行
+    Barrier,     // execute() 等待全部接收者完成后返回
 };
 
 // 命令A
 class CommandA : public Command {
+private:
+    // 同一接收者的串行执行队列, 由于每次动作相同, 只需记录待执行次数
+    struct Strand {
+        std::atomic<std::size_t> pending{ 0 };
+    };
+
+    std::shared_ptr<CommandExecutor> m_pool;
+    FanOutOrder m_order = FanOutOrder::Barrier;
+    std::vector<std::shared_ptr<Strand>> m_strands;
+
+    void execute_fan_out() const;
+
 public:
     CommandA(const std::vector<std::shared_ptr<Reciever>>& recievers) {
         m_receivers = recievers;
     }
 
+    // 在共享线程池上并行执行各接收者的动作, pool 为空时恢复依次执行
+    void set_fan_out(const std::shared_ptr<CommandExecutor>& pool,
+                     FanOutOrder order = FanOutOrder::Barrier) {
+        m_pool = pool;
+        m_order = order;
+        m_strands.clear();
+        for (std::size_t i = 0; i < m_receivers.size(); ++i) {
+            m_strands.push_back(std::make_shared<Strand>());
+        }
+    }
+
     void execute() const override {
+        if (m_pool) {
+            execute_fan_out();
+            return;
+        }
         for (const auto& receiver: m_receivers) {
             receiver->action();
         }
     }
+
+    std::string type_name() const override {
+        return "CommandA";
+    }
+
+    // 参数为以逗号分隔的接收者名称
+    void encode(std::string& out) const override {
+        for (const auto& receiver: m_receivers) {
+            if (!out.empty()) {
+                out += ',';
+            }
+            out += receiver->name();
+        }
+    }
 };
 
 // 调用者
@@ -143,6 +260,1420 @@ public:
     }
 };
 
+// 有界无锁多生产者多消费者队列(Dmitry Vyukov 算法).
+// 每个槽位带序号: 序号等于写位置时可写, 等于写位置 + 1 时可读,
+// 生产者与消费者各自通过 CAS 推进位置, 互不加锁.
+template <class T>
+class MpmcQueue {
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> buffer_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{ 0 };
+    alignas(64) std::atomic<std::size_t> dequeue_pos_{ 0 };
+
+public:
+    // 容量向上取整为 2 的幂
+    explicit MpmcQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buffer_.reset(new Cell[size]);
+        mask_ = size - 1;
+        for (std::size_t i = 0; i < size; ++i) {
+            buffer_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t capacity() const {
+        return mask_ + 1;
+    }
+
+    // 队列满时返回 false, value 保持不变
+    bool try_push(T& value) {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = buffer_[pos & mask_];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) -
+                                  static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 队列空时返回 false
+    bool try_pop(T& value) {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = buffer_[pos & mask_];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) -
+                                  static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.data);
+                    cell.sequence.store(pos + mask_ + 1,
+                                        std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 近似长度, 并发修改时仅供观测
+    std::size_t size_approx() const {
+        std::size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+        std::size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+};
+
+// 执行服务的统计信息, 时间单位为微秒
+struct ExecutorStats {
+    std::size_t queue_depth = 0;
+    std::size_t submitted = 0;
+    std::size_t executed = 0;
+    std::size_t rejected = 0;
+    double avg_wait_us = 0;
+    double max_wait_us = 0;
+    double avg_exec_us = 0;
+    double max_exec_us = 0;
+};
+
+// 命令执行服务: 命令经无锁队列交给工作线程池执行.
+// 工作线程在队列为空时休眠, 有新命令时被唤醒; 队列满时 submit 休眠,
+// 有空位时被唤醒. 唤醒信号只用于休眠, 队列本身不加锁.
+//
+// 休眠方先增加休眠计数再检查队列, 唤醒方先修改队列再读取休眠计数,
+// 两侧之间各有一道 seq_cst 栅栏, 因此至少有一方能看到对方的写入:
+// 要么休眠方看到新状态而不休眠, 要么唤醒方看到计数而发出通知.
+// 休眠方从增加计数到进入等待一直持有互斥锁, 通知不会落在两者之间.
+class CommandExecutor {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        std::shared_ptr<Command> command;
+        std::promise<void> done;
+        Clock::time_point enqueued;
+    };
+
+    MpmcQueue<Task> queue_;
+    std::vector<std::thread> workers_;
+    std::atomic<bool> stopping_{ false };
+
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    std::atomic<unsigned> parked_{ 0 };
+
+    std::mutex space_mutex_;
+    std::condition_variable space_cv_;
+    std::atomic<unsigned> blocked_{ 0 }; // 等待空位的 submit 调用数
+
+    std::atomic<std::size_t> submitted_{ 0 };
+    std::atomic<std::size_t> executed_{ 0 };
+    std::atomic<std::size_t> rejected_{ 0 };
+    std::atomic<long long> wait_ns_{ 0 };
+    std::atomic<long long> max_wait_ns_{ 0 };
+    std::atomic<long long> exec_ns_{ 0 };
+    std::atomic<long long> max_exec_ns_{ 0 };
+
+    static void update_max(std::atomic<long long>& max, long long value) {
+        long long current = max.load(std::memory_order_relaxed);
+        while (value > current &&
+               !max.compare_exchange_weak(current, value,
+                                          std::memory_order_relaxed)) {
+        }
+    }
+
+    // 入队之后调用
+    void wake_one() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            park_cv_.notify_one();
+        }
+    }
+
+    // 出队之后调用
+    void wake_producer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (blocked_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(space_mutex_);
+            space_cv_.notify_one();
+        }
+    }
+
+    bool push(Task& task) {
+        task.enqueued = Clock::now();
+        if (!queue_.try_push(task)) {
+            return false;
+        }
+        submitted_.fetch_add(1, std::memory_order_relaxed);
+        wake_one();
+        return true;
+    }
+
+    void run(Task& task) {
+        auto start = Clock::now();
+        std::exception_ptr error;
+        try {
+            task.command->execute();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        auto stop = Clock::now();
+        long long wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             start - task.enqueued)
+                             .count();
+        long long exec =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+                .count();
+        wait_ns_.fetch_add(wait, std::memory_order_relaxed);
+        exec_ns_.fetch_add(exec, std::memory_order_relaxed);
+        update_max(max_wait_ns_, wait);
+        update_max(max_exec_ns_, exec);
+        executed_.fetch_add(1, std::memory_order_relaxed);
+        task.command.reset();
+
+        // 统计先于完成通知更新, 等待者看到的统计已包含本命令
+        if (error) {
+            task.done.set_exception(error);
+        } else {
+            task.done.set_value();
+        }
+    }
+
+    void worker_loop() {
+        Task task;
+        for (;;) {
+            if (queue_.try_pop(task)) {
+                wake_producer();
+                run(task);
+                continue;
+            }
+            if (stopping_.load()) {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            parked_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            park_cv_.wait(lock, [this]() {
+                return stopping_.load() || queue_.size_approx() > 0;
+            });
+            parked_.fetch_sub(1);
+        }
+    }
+
+public:
+    // workers 为 0 时使用全部硬件线程
+    explicit CommandExecutor(unsigned workers = 0,
+                             std::size_t capacity = 1024) :
+        queue_(capacity) {
+        if (workers == 0) {
+            workers = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned i = 0; i < workers; ++i) {
+            workers_.emplace_back(&CommandExecutor::worker_loop, this);
+        }
+    }
+
+    CommandExecutor(const CommandExecutor&) = delete;
+    CommandExecutor& operator=(const CommandExecutor&) = delete;
+
+    // 执行完队列中剩余的命令后停止
+    ~CommandExecutor() {
+        stopping_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            park_cv_.notify_all();
+        }
+        for (std::thread& worker: workers_) {
+            worker.join();
+        }
+    }
+
+    // 队列满时立即返回 false(背压)并计入 rejected, 成功时 done 为完成通知
+    bool try_submit(const std::shared_ptr<Command>& command,
+                    std::future<void>& done) {
+        Task task{ command, std::promise<void>(), Clock::time_point() };
+        std::future<void> future = task.done.get_future();
+        if (!push(task)) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        done = std::move(future);
+        return true;
+    }
+
+    // 队列满时休眠等待空位, 不计入 rejected
+    std::future<void> submit(const std::shared_ptr<Command>& command) {
+        Task task{ command, std::promise<void>(), Clock::time_point() };
+        std::future<void> done = task.done.get_future();
+        while (!push(task)) {
+            std::unique_lock<std::mutex> lock(space_mutex_);
+            blocked_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            space_cv_.wait(lock, [this]() {
+                return queue_.size_approx() < queue_.capacity();
+            });
+            blocked_.fetch_sub(1);
+        }
+        return done;
+    }
+
+    ExecutorStats stats() const {
+        ExecutorStats s;
+        s.queue_depth = queue_.size_approx();
+        s.submitted = submitted_.load();
+        s.executed = executed_.load();
+        s.rejected = rejected_.load();
+        if (s.executed > 0) {
+            s.avg_wait_us = wait_ns_.load() / 1e3 / s.executed;
+            s.avg_exec_us = exec_ns_.load() / 1e3 / s.executed;
+        }
+        s.max_wait_us = max_wait_ns_.load() / 1e3;
+        s.max_exec_us = max_exec_ns_.load() / 1e3;
+        return s;
+    }
+};
+
+// 在线程池上执行一个接收者动作的任务
+class ReceiverTask : public Command {
+private:
+    std::function<void()> m_run;
+
+public:
+    explicit ReceiverTask(std::function<void()> run) : m_run(std::move(run)) {
+    }
+
+    void execute() const override {
+        m_run();
+    }
+};
+
+// 屏障模式下的一次扇出: 每个动作只会被线程池或调用线程之一认领执行.
+// 动作抛出异常时仍计为完成, 第一个异常通过 done 交给等待者.
+struct FanOutBarrier {
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    std::atomic<std::size_t> remaining;
+    std::atomic<bool> failed{ false };
+    std::exception_ptr error; // 只由把 failed 置为 true 的线程写入
+    std::promise<void> done;
+
+    explicit FanOutBarrier(std::size_t n) :
+        claimed(new std::atomic<bool>[n]), remaining(n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            claimed[i].store(false);
+        }
+    }
+
+    void run(std::size_t i, const Reciever& receiver) {
+        if (claimed[i].exchange(true)) {
+            return;
+        }
+        try {
+            receiver.action();
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                error = std::current_exception();
+            }
+        }
+        // fetch_sub 使最后一个完成者看到其他线程写入的 error
+        if (remaining.fetch_sub(1) == 1) {
+            if (error) {
+                done.set_exception(error);
+            } else {
+                done.set_value();
+            }
+        }
+    }
+};
+
+// 屏障模式下提交不等待队列空位, 未能入队的动作留给调用线程执行;
+// 调用线程再按顺序认领尚未开始的动作, 之后只等待已被工作线程认领且
+// 正在执行的动作. 因此即使在同一线程池的工作线程中执行命令也不会
+// 因等待自己或等待队列空位而死锁, 总延迟约为最慢接收者的耗时.
+// None 与 PerReceiver 模式在队列满时等待空位, 在同一线程池的工作线程中
+// 使用时, 若所有工作线程都阻塞在提交上则会死锁.
+void CommandA::execute_fan_out() const {
+    if (m_order == FanOutOrder::Barrier) {
+        if (m_receivers.empty()) {
+            return;
+        }
+        auto barrier = std::make_shared<FanOutBarrier>(m_receivers.size());
+        std::future<void> done = barrier->done.get_future();
+        std::future<void> queued;
+        for (std::size_t i = 0; i < m_receivers.size(); ++i) {
+            auto receiver = m_receivers[i];
+            if (!m_pool->try_submit(
+                    std::make_shared<ReceiverTask>([barrier, receiver, i]() {
+                        barrier->run(i, *receiver);
+                    }),
+                    queued)) {
+                break;
+            }
+        }
+        for (std::size_t i = 0; i < m_receivers.size(); ++i) {
+            barrier->run(i, *m_receivers[i]);
+        }
+        done.get();
+        return;
+    }
+
+    for (std::size_t i = 0; i < m_receivers.size(); ++i) {
+        auto receiver = m_receivers[i];
+        if (m_order == FanOutOrder::None) {
+            m_pool->submit(std::make_shared<ReceiverTask>(
+                [receiver]() { receiver->action(); }));
+            continue;
+        }
+        // 只有从 0 变为 1 的提交者负责启动执行, 执行者一直运行到计数归零
+        auto strand = m_strands[i];
+        if (strand->pending.fetch_add(1) == 0) {
+            m_pool->submit(std::make_shared<ReceiverTask>([strand, receiver]() {
+                // 动作抛出的异常被丢弃, 执行者必须继续运行直到计数归零
+                do {
+                    try {
+                        receiver->action();
+                    } catch (...) {
+                    }
+                } while (strand->pending.fetch_sub(1) > 1);
+            }));
+        }
+    }
+}
+
+// 模拟耗时的接收者
+class SlowReciever : public Reciever {
+private:
+    std::chrono::milliseconds m_latency;
+
+public:
+    explicit SlowReciever(std::chrono::milliseconds latency) :
+        m_latency(latency) {
+    }
+
+    const char* name() const override {
+        return "SlowReciever";
+    }
+
+    void action() const override {
+        std::this_thread::sleep_for(m_latency);
+    }
+};
+
+// 广播命令的延迟: 依次执行为各接收者耗时之和, 屏障扇出约为其中最大值
+void fan_out_benchmark() {
+    std::vector<std::shared_ptr<Reciever>> receivers;
+    for (int ms = 1; ms <= 8; ++ms) {
+        receivers.push_back(
+            std::make_shared<SlowReciever>(std::chrono::milliseconds(ms)));
+    }
+    CommandA command(receivers);
+
+    auto start = std::chrono::steady_clock::now();
+    command.execute();
+    auto stop = std::chrono::steady_clock::now();
+    std::cout << "sequential: "
+              << std::chrono::duration<double, std::milli>(stop - start)
+                     .count()
+              << " ms" << std::endl;
+
+    command.set_fan_out(std::make_shared<CommandExecutor>(8),
+                        FanOutOrder::Barrier);
+    start = std::chrono::steady_clock::now();
+    command.execute();
+    stop = std::chrono::steady_clock::now();
+    std::cout << "fan-out:    "
+              << std::chrono::duration<double, std::milli>(stop - start)
+                     .count()
+              << " ms" << std::endl;
+}
+
+void print_stats(const ExecutorStats& s) {
+    std::cout << "depth " << s.queue_depth << ", submitted " << s.submitted
+              << ", executed " << s.executed << ", rejected " << s.rejected
+              << ", wait avg/max " << s.avg_wait_us << "/" << s.max_wait_us
+              << " us, exec avg/max " << s.avg_exec_us << "/"
+              << s.max_exec_us << " us" << std::endl;
+}
+
+// 调度类别配置, 下标越小优先级越高
+struct SchedulerClass {
+    std::string name;
+    unsigned max_concurrency; // 该类别同时执行的命令数上限
+};
+
+// 某个类别的排队延迟统计, 单位为微秒
+struct LatencySummary {
+    std::size_t count = 0;
+    std::size_t deadline_misses = 0;
+    double p50_us = 0;
+    double p90_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+};
+
+// 优先级与截止时间感知的命令调度器, 与 Invoke 一样只负责何时执行命令.
+// 工作线程每次按以下顺序选择命令:
+// 1. 防饿死: 若某个未达并发上限的类别中最早到达的命令已等待超过
+//    starvation_limit, 先执行等待最久的那个;
+// 2. 否则按优先级从高到低找第一个未达并发上限且非空的类别,
+//    取其中截止时间最早的命令(无截止时间的排在最后, 同截止时间先到先执行).
+class CommandScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    struct Task {
+        std::shared_ptr<Command> command;
+        std::promise<void> done;
+        Clock::time_point enqueued;
+        Clock::time_point deadline;
+        bool has_deadline = false;
+        std::uint64_t seq = 0;
+        bool taken = false;
+    };
+
+    using TaskPtr = std::shared_ptr<Task>;
+
+    struct Later {
+        bool operator()(const TaskPtr& a, const TaskPtr& b) const {
+            if (a->has_deadline != b->has_deadline) {
+                return !a->has_deadline;
+            }
+            if (a->has_deadline && a->deadline != b->deadline) {
+                return a->deadline > b->deadline;
+            }
+            return a->seq > b->seq;
+        }
+    };
+
+    static constexpr std::size_t kSamples = 4096; // 每个类别保留的延迟样本数
+
+    struct Queue {
+        SchedulerClass config;
+        std::priority_queue<TaskPtr, std::vector<TaskPtr>, Later> edf;
+        std::deque<TaskPtr> arrival; // 按到达顺序, 已取走的条目延迟清理
+        std::size_t waiting = 0;
+        unsigned running = 0;
+        std::vector<double> samples_us;
+        std::size_t next_sample = 0;
+        std::size_t count = 0;
+        std::size_t deadline_misses = 0;
+    };
+
+    std::vector<Queue> queues_;
+    std::chrono::microseconds starvation_limit_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::uint64_t next_seq_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    bool eligible(const Queue& q) const {
+        return q.waiting > 0 && q.running < q.config.max_concurrency;
+    }
+
+    // 在持有锁时选出下一个命令, 没有可执行的命令时返回空
+    TaskPtr pick(std::size_t& cls, Clock::time_point now) {
+        std::size_t starving = queues_.size();
+        Clock::time_point oldest = now - starvation_limit_;
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            Queue& q = queues_[i];
+            while (!q.arrival.empty() && q.arrival.front()->taken) {
+                q.arrival.pop_front();
+            }
+            if (eligible(q) && q.arrival.front()->enqueued < oldest) {
+                oldest = q.arrival.front()->enqueued;
+                starving = i;
+            }
+        }
+        if (starving < queues_.size()) {
+            cls = starving;
+            TaskPtr task = queues_[cls].arrival.front();
+            queues_[cls].arrival.pop_front();
+            return task;
+        }
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            Queue& q = queues_[i];
+            if (!eligible(q)) {
+                continue;
+            }
+            while (q.edf.top()->taken) {
+                q.edf.pop();
+            }
+            cls = i;
+            TaskPtr task = q.edf.top();
+            q.edf.pop();
+            return task;
+        }
+        return nullptr;
+    }
+
+    void record(Queue& q, const Task& task, Clock::time_point start) {
+        double wait_us =
+            std::chrono::duration<double, std::micro>(start - task.enqueued)
+                .count();
+        if (q.samples_us.size() < kSamples) {
+            q.samples_us.push_back(wait_us);
+        } else {
+            q.samples_us[q.next_sample] = wait_us;
+        }
+        q.next_sample = (q.next_sample + 1) % kSamples;
+        ++q.count;
+        if (task.has_deadline && start > task.deadline) {
+            ++q.deadline_misses;
+        }
+    }
+
+    void worker_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            std::size_t cls = 0;
+            TaskPtr task = pick(cls, Clock::now());
+            if (!task) {
+                bool empty = true;
+                for (const Queue& q: queues_) {
+                    empty = empty && q.waiting == 0;
+                }
+                if (stopping_ && empty) {
+                    // 唤醒其余空闲的工作线程, 让它们也看到队列已空
+                    cv_.notify_all();
+                    return;
+                }
+                // 没有可选命令说明所有类别都为空或已达并发上限. 饿死规则只
+                // 决定在可执行的命令中选哪一个, 时间流逝不会让命令变得可执行,
+                // 因此不设超时, 只等提交或其他命令完成时的通知.
+                cv_.wait(lock);
+                continue;
+            }
+            Queue& q = queues_[cls];
+            task->taken = true;
+            --q.waiting;
+            ++q.running;
+            record(q, *task, Clock::now());
+            lock.unlock();
+
+            try {
+                task->command->execute();
+                task->done.set_value();
+            } catch (...) {
+                task->done.set_exception(std::current_exception());
+            }
+            task->command.reset();
+
+            lock.lock();
+            --q.running;
+            cv_.notify_one();
+        }
+    }
+
+public:
+    CommandScheduler(std::vector<SchedulerClass> classes, unsigned workers,
+                     std::chrono::microseconds starvation_limit =
+                         std::chrono::milliseconds(50)) :
+        starvation_limit_(starvation_limit) {
+        for (SchedulerClass& c: classes) {
+            queues_.emplace_back();
+            queues_.back().config = std::move(c);
+            if (queues_.back().config.max_concurrency == 0) {
+                queues_.back().config.max_concurrency = 1;
+            }
+        }
+        for (unsigned i = 0; i < std::max(workers, 1u); ++i) {
+            workers_.emplace_back(&CommandScheduler::worker_loop, this);
+        }
+    }
+
+    CommandScheduler(const CommandScheduler&) = delete;
+    CommandScheduler& operator=(const CommandScheduler&) = delete;
+
+    // 执行完所有已提交的命令后停止
+    ~CommandScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& worker: workers_) {
+            worker.join();
+        }
+    }
+
+    // 提交到类别 cls, 可选截止时间; 类别不存在时 future 携带异常
+    std::future<void>
+    submit(const std::shared_ptr<Command>& command, std::size_t cls,
+           std::optional<Clock::time_point> deadline = std::nullopt) {
+        auto task = std::make_shared<Task>();
+        std::future<void> done = task->done.get_future();
+        if (cls >= queues_.size()) {
+            task->done.set_exception(std::make_exception_ptr(
+                std::out_of_range("unknown scheduler class")));
+            return done;
+        }
+        task->command = command;
+        task->enqueued = Clock::now();
+        task->has_deadline = deadline.has_value();
+        task->deadline = deadline.value_or(Clock::time_point::max());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task->seq = next_seq_++;
+            Queue& q = queues_[cls];
+            q.edf.push(task);
+            q.arrival.push_back(task);
+            ++q.waiting;
+        }
+        cv_.notify_one();
+        return done;
+    }
+
+    std::size_t class_count() const {
+        return queues_.size();
+    }
+
+    // 类别 cls 最近样本的排队延迟分位数
+    LatencySummary latency(std::size_t cls) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        LatencySummary summary;
+        const Queue& q = queues_.at(cls);
+        summary.count = q.count;
+        summary.deadline_misses = q.deadline_misses;
+        std::vector<double> samples = q.samples_us;
+        if (samples.empty()) {
+            return summary;
+        }
+        std::sort(samples.begin(), samples.end());
+        auto at = [&samples](double p) {
+            return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+        };
+        summary.p50_us = at(0.50);
+        summary.p90_us = at(0.90);
+        summary.p99_us = at(0.99);
+        summary.max_us = samples.back();
+        return summary;
+    }
+
+    const std::string& class_name(std::size_t cls) const {
+        return queues_.at(cls).config.name;
+    }
+};
+
+// 交互命令与批量命令混合提交时各类别的排队延迟
+void scheduler_benchmark() {
+    CommandScheduler scheduler({ { "interactive", 2 }, { "bulk", 1 } }, 2,
+                               std::chrono::milliseconds(20));
+    using Receivers = std::vector<std::shared_ptr<Reciever>>;
+    auto bulk = std::make_shared<CommandA>(Receivers{
+        std::make_shared<SlowReciever>(std::chrono::milliseconds(1)) });
+    auto interactive = std::make_shared<CommandA>(Receivers{
+        std::make_shared<SlowReciever>(std::chrono::milliseconds(0)) });
+
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < 100; ++i) {
+        done.push_back(scheduler.submit(bulk, 1));
+    }
+    for (int i = 0; i < 50; ++i) {
+        auto deadline =
+            CommandScheduler::Clock::now() + std::chrono::milliseconds(5);
+        done.push_back(scheduler.submit(interactive, 0, deadline));
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    for (std::future<void>& f: done) {
+        f.get();
+    }
+    for (std::size_t c = 0; c < scheduler.class_count(); ++c) {
+        LatencySummary l = scheduler.latency(c);
+        std::cout << scheduler.class_name(c) << ": " << l.count
+                  << " commands, wait p50/p90/p99/max " << l.p50_us << "/"
+                  << l.p90_us << "/" << l.p99_us << "/" << l.max_us
+                  << " us, deadline misses " << l.deadline_misses
+                  << std::endl;
+    }
+}
+
+// 文本文档, 编辑命令的接收者
+class TextDocument {
+private:
+    std::string text_;
+
+public:
+    void insert(std::size_t pos, const std::string& text) {
+        text_.insert(std::min(pos, text_.size()), text);
+    }
+
+    void erase(std::size_t pos, std::size_t len) {
+        if (pos < text_.size()) {
+            text_.erase(pos, len);
+        }
+    }
+
+    const std::string& text() const {
+        return text_;
+    }
+};
+
+// 编辑命令: 在 pos 处插入 text, 或从 pos 起删除 len 个字符
+class EditCommand : public Command {
+public:
+    enum Kind : std::uint8_t
+    {
+        kInsert = 0,
+        kErase = 1,
+    };
+
+private:
+    TextDocument& doc_;
+    Kind kind_;
+    std::size_t pos_;
+    std::string text_; // 插入的文本, 或删除前捕获的被删文本
+
+public:
+    static EditCommand insert(TextDocument& doc, std::size_t pos,
+                              std::string text) {
+        return EditCommand(doc, kInsert, pos, std::move(text));
+    }
+
+    // 创建时捕获将被删除的文本, 供撤销时恢复
+    static EditCommand erase(TextDocument& doc, std::size_t pos,
+                             std::size_t len) {
+        std::string removed =
+            pos < doc.text().size() ? doc.text().substr(pos, len) : "";
+        return EditCommand(doc, kErase, pos, std::move(removed));
+    }
+
+    EditCommand(TextDocument& doc, Kind kind, std::size_t pos,
+                std::string text) :
+        doc_(doc), kind_(kind), pos_(pos), text_(std::move(text)) {
+    }
+
+    void execute() const override {
+        if (kind_ == kInsert) {
+            doc_.insert(pos_, text_);
+        } else {
+            doc_.erase(pos_, text_.size());
+        }
+    }
+
+    void undo() const override {
+        if (kind_ == kInsert) {
+            doc_.erase(pos_, text_.size());
+        } else {
+            doc_.insert(pos_, text_);
+        }
+    }
+
+    Kind kind() const {
+        return kind_;
+    }
+    std::size_t pos() const {
+        return pos_;
+    }
+    const std::string& text() const {
+        return text_;
+    }
+};
+
+// 撤销/重做历史.
+// 每条记录序列化为 [kind u8][pos u32][len u32][text], 存放在容量固定的
+// 环形字节缓冲区中, 不为单条记录分配内存. 写入位置空间不足时淘汰最旧的记录;
+// 新命令会丢弃所有可重做记录. 紧接在上一条插入之后的插入会合并为一条记录,
+// 连续输入只占用一条历史.
+class CommandHistory {
+private:
+    struct Entry {
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    static constexpr std::size_t kHeader = 9;
+    static constexpr std::size_t kMaxMerge = 256; // 合并后文本的最大长度
+
+    TextDocument& doc_;
+    std::vector<char> ring_;
+    std::deque<Entry> entries_;
+    std::size_t cursor_ = 0; // [0, cursor_) 可撤销, [cursor_, size) 可重做
+
+    EditCommand decode(const Entry& e) const {
+        const char* p = ring_.data() + e.offset;
+        std::uint32_t pos, len;
+        std::memcpy(&pos, p + 1, 4);
+        std::memcpy(&len, p + 5, 4);
+        return EditCommand(doc_, static_cast<EditCommand::Kind>(p[0]), pos,
+                           std::string(p + kHeader, len));
+    }
+
+    // 追加一条记录, 单条记录超过容量时返回 false
+    bool push(EditCommand::Kind kind, std::size_t pos,
+              const std::string& text) {
+        std::size_t n = kHeader + text.size();
+        if (n > ring_.size()) {
+            return false;
+        }
+        std::size_t at =
+            entries_.empty() ? 0 : entries_.back().offset + entries_.back().size;
+        if (at + n > ring_.size()) {
+            // 尾部空间不足: 先淘汰仍位于尾部的最旧记录, 再回绕到起点
+            while (!entries_.empty() && entries_.front().offset >= at) {
+                entries_.pop_front();
+                --cursor_;
+            }
+            at = 0;
+        }
+        while (!entries_.empty() && entries_.front().offset >= at &&
+               entries_.front().offset < at + n) {
+            entries_.pop_front();
+            --cursor_;
+        }
+        char* p = ring_.data() + at;
+        std::uint32_t pos32 = static_cast<std::uint32_t>(pos);
+        std::uint32_t len32 = static_cast<std::uint32_t>(text.size());
+        p[0] = static_cast<char>(kind);
+        std::memcpy(p + 1, &pos32, 4);
+        std::memcpy(p + 5, &len32, 4);
+        std::memcpy(p + kHeader, text.data(), text.size());
+        entries_.push_back(Entry{ at, n });
+        ++cursor_;
+        return true;
+    }
+
+public:
+    // capacity 为历史记录可占用的最大字节数
+    CommandHistory(TextDocument& doc, std::size_t capacity) :
+        doc_(doc), ring_(capacity) {
+    }
+
+    // 执行编辑命令并记录到历史
+    void execute(const EditCommand& command) {
+        command.execute();
+        while (entries_.size() > cursor_) {
+            entries_.pop_back();
+        }
+        if (command.kind() == EditCommand::kInsert && cursor_ > 0) {
+            EditCommand last = decode(entries_.back());
+            if (last.kind() == EditCommand::kInsert &&
+                last.pos() + last.text().size() == command.pos() &&
+                last.text().size() + command.text().size() <= kMaxMerge) {
+                entries_.pop_back();
+                --cursor_;
+                if (!push(EditCommand::kInsert, last.pos(),
+                          last.text() + command.text())) {
+                    clear();
+                }
+                return;
+            }
+        }
+        // 记录放不下时更早的历史也无法正确撤销, 整体清空
+        if (!push(command.kind(), command.pos(), command.text())) {
+            clear();
+        }
+    }
+
+    void clear() {
+        entries_.clear();
+        cursor_ = 0;
+    }
+
+    bool undo() {
+        if (cursor_ == 0) {
+            return false;
+        }
+        decode(entries_[--cursor_]).undo();
+        return true;
+    }
+
+    bool redo() {
+        if (cursor_ == entries_.size()) {
+            return false;
+        }
+        decode(entries_[cursor_++]).execute();
+        return true;
+    }
+
+    std::size_t size() const {
+        return entries_.size();
+    }
+
+    // 历史记录实际占用的字节数
+    std::size_t bytes_used() const {
+        std::size_t bytes = 0;
+        for (const Entry& e: entries_) {
+            bytes += e.size;
+        }
+        return bytes;
+    }
+};
+
+// 历史记录的内存占用与撤销延迟, 对比保存整份文档副本的做法
+void history_benchmark(std::size_t doc_size, std::size_t edits) {
+    TextDocument doc;
+    doc.insert(0, std::string(doc_size, 'x'));
+    CommandHistory history(doc, 1 << 20);
+
+    // 每输入 8 个字符后跳到别处输入, 模拟分散的编辑
+    for (std::size_t i = 0; i < edits; ++i) {
+        std::size_t pos = (i / 8) * 97 % doc_size + i % 8;
+        history.execute(EditCommand::insert(doc, pos, "a"));
+    }
+    std::size_t entries = history.size();
+    std::cout << "history entries: " << entries << ", "
+              << static_cast<double>(history.bytes_used()) / entries
+              << " bytes/entry (full copy: " << doc.text().size()
+              << " bytes/entry)" << std::endl;
+
+    std::size_t undone = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (history.undo()) {
+        ++undone;
+    }
+    auto stop = std::chrono::steady_clock::now();
+    std::cout << "undo: "
+              << std::chrono::duration<double, std::nano>(stop - start)
+                         .count() /
+                     std::max<std::size_t>(undone, 1)
+              << " ns/op" << std::endl;
+}
+
+// 可持久化命令的解码表: 类型名 -> 根据参数重建命令
+class CommandCodec {
+public:
+    using Decoder =
+        std::function<std::shared_ptr<Command>(const std::string& payload)>;
+
+    void add(const std::string& type_name, Decoder decoder) {
+        decoders_[type_name] = std::move(decoder);
+    }
+
+    // 未知类型返回 nullptr
+    std::shared_ptr<Command> decode(const std::string& type_name,
+                                    const std::string& payload) const {
+        auto it = decoders_.find(type_name);
+        return it == decoders_.end() ? nullptr : it->second(payload);
+    }
+
+private:
+    std::map<std::string, Decoder> decoders_;
+};
+
+#if COMMAND_HAS_WAL
+namespace wal {
+inline std::uint32_t crc32(const char* data, std::size_t size) {
+    static const auto table = []() {
+        std::vector<std::uint32_t> t(256);
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^
+              (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+inline void put(std::string& out, std::uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out += static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+inline std::uint64_t get(const char* p, int bytes) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) {
+        v |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i]))
+             << (8 * i);
+    }
+    return v;
+}
+
+// 把文件数据刷到存储介质. macOS 的 fsync 只写到磁盘缓存,
+// 需要 F_FULLFSYNC; 没有 fdatasync 的平台退回 fsync.
+inline bool sync(int fd) {
+#if defined(__APPLE__)
+    return fcntl(fd, F_FULLFSYNC) == 0 || fsync(fd) == 0;
+#elif defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+    return fdatasync(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+
+// 在临时目录创建名称唯一的空文件并返回其路径
+inline std::string temp_path(const std::string& stem) {
+    std::string path =
+        (std::filesystem::temp_directory_path() / (stem + "_XXXXXX"))
+            .string();
+    int fd = mkstemp(path.data());
+    if (fd < 0) {
+        throw std::runtime_error("cannot create temporary file " + path);
+    }
+    ::close(fd);
+    return path;
+}
+
+inline bool read_file(const std::string& path, std::string& out) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    char buf[4096];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+        out.append(buf, n);
+    }
+    std::fclose(file);
+    return true;
+}
+}
+
+// 持久化命令日志.
+// 日志记录格式(小端序): [body_len u32][crc32(body) u32][body],
+//   body = [seq u64][type_len u16][type][payload]
+// submit() 在调用线程编码记录, 提交线程把积攒的记录一次写入并 fdatasync,
+// 落盘后按序执行并完成 future. checkpoint() 记录已执行的最大序号并清空日志;
+// 构造时重放检查点之后的完整记录, 遇到残缺的尾部记录即截断.
+// 写入或同步失败时日志截断回最后一个完整批次的末尾, 之后拒绝所有提交:
+// 同步失败后内核可能已丢弃脏页, 继续追加无法保证之前的记录已落盘.
+class DurableCommandLog {
+private:
+    struct Pending {
+        std::shared_ptr<Command> command;
+        std::promise<void> done;
+        std::string record;
+        std::uint64_t seq = 0;
+    };
+
+    std::string path_;
+    std::string checkpoint_path_;
+    int fd_ = -1;
+    std::size_t max_batch_;
+    std::chrono::microseconds max_delay_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Pending> pending_;
+    std::uint64_t next_seq_ = 1;
+    bool stopping_ = false;
+
+    std::mutex log_mutex_;      // 写日志与检查点互斥
+    std::size_t log_size_ = 0;  // 最后一个完整批次之后的偏移
+    std::exception_ptr failed_; // 首次 I/O 错误, 之后的提交都以它失败
+    std::uint64_t applied_seq_ = 0;
+    std::size_t replayed_ = 0;
+    std::atomic<std::size_t> syncs_{ 0 };
+    std::thread committer_;
+
+    void replay(const CommandCodec& codec) {
+        std::string checkpoint;
+        if (wal::read_file(checkpoint_path_, checkpoint) &&
+            checkpoint.size() == 8) {
+            applied_seq_ = wal::get(checkpoint.data(), 8);
+        }
+        next_seq_ = applied_seq_ + 1;
+
+        std::string log;
+        wal::read_file(path_, log);
+        std::size_t offset = 0;
+        while (offset + 8 <= log.size()) {
+            std::size_t len = wal::get(log.data() + offset, 4);
+            std::uint32_t crc = wal::get(log.data() + offset + 4, 4);
+            const char* body = log.data() + offset + 8;
+            if (len < 10 || offset + 8 + len > log.size() ||
+                wal::crc32(body, len) != crc) {
+                break;
+            }
+            std::uint64_t seq = wal::get(body, 8);
+            std::size_t type_len = wal::get(body + 8, 2);
+            if (10 + type_len > len) {
+                break;
+            }
+            if (seq > applied_seq_) {
+                std::shared_ptr<Command> command = codec.decode(
+                    std::string(body + 10, type_len),
+                    std::string(body + 10 + type_len, len - 10 - type_len));
+                if (command) {
+                    command->execute();
+                    ++replayed_;
+                }
+                applied_seq_ = seq;
+                next_seq_ = seq + 1;
+            }
+            offset += 8 + len;
+        }
+        // 截断残缺的尾部记录, 之后的追加从完整记录之后开始
+        if (offset < log.size()) {
+            if (ftruncate(fd_, static_cast<off_t>(offset)) != 0) {
+                throw std::runtime_error("cannot truncate command log " +
+                                         path_);
+            }
+        }
+        log_size_ = offset;
+    }
+
+    // 把一批记录追加到日志并落盘, 失败时截断回 log_size_ 并抛出异常
+    void append(const std::string& bytes) {
+        std::size_t written = 0;
+        while (written < bytes.size()) {
+            ssize_t n =
+                ::write(fd_, bytes.data() + written, bytes.size() - written);
+            if (n <= 0) {
+                break;
+            }
+            written += static_cast<std::size_t>(n);
+        }
+        if (written == bytes.size() && wal::sync(fd_)) {
+            log_size_ += bytes.size();
+            return;
+        }
+        if (ftruncate(fd_, static_cast<off_t>(log_size_)) != 0) {
+            throw std::runtime_error(
+                "command log write failed, cannot truncate: " + path_);
+        }
+        throw std::runtime_error("command log write failed: " + path_);
+    }
+
+    void commit_loop() {
+        std::vector<Pending> batch;
+        std::string bytes;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock,
+                         [this]() { return stopping_ || !pending_.empty(); });
+                if (pending_.empty()) {
+                    return;
+                }
+                // 等待更多命令加入本批, 直到批满或超时
+                cv_.wait_for(lock, max_delay_, [this]() {
+                    return stopping_ || pending_.size() >= max_batch_;
+                });
+                std::size_t n = std::min(pending_.size(), max_batch_);
+                batch.clear();
+                for (std::size_t i = 0; i < n; ++i) {
+                    batch.push_back(std::move(pending_[i]));
+                }
+                pending_.erase(pending_.begin(), pending_.begin() + n);
+            }
+
+            std::lock_guard<std::mutex> log_lock(log_mutex_);
+            if (!failed_) {
+                bytes.clear();
+                for (const Pending& p: batch) {
+                    bytes += p.record;
+                }
+                try {
+                    append(bytes);
+                    syncs_.fetch_add(1);
+                } catch (...) {
+                    failed_ = std::current_exception();
+                }
+            }
+
+            for (Pending& p: batch) {
+                if (failed_) {
+                    p.done.set_exception(failed_);
+                    continue;
+                }
+                try {
+                    p.command->execute();
+                    p.done.set_value();
+                } catch (...) {
+                    p.done.set_exception(std::current_exception());
+                }
+                applied_seq_ = p.seq;
+            }
+        }
+    }
+
+public:
+    // max_batch: 每次 fsync 最多包含的命令数; max_delay: 凑批的最长等待时间
+    DurableCommandLog(const std::string& path, const CommandCodec& codec,
+                      std::size_t max_batch = 64,
+                      std::chrono::microseconds max_delay =
+                          std::chrono::microseconds(200)) :
+        path_(path),
+        checkpoint_path_(path + ".ckpt"), max_batch_(std::max<std::size_t>(
+                                              max_batch, 1)),
+        max_delay_(max_delay) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("cannot open command log " + path);
+        }
+        replay(codec);
+        committer_ = std::thread(&DurableCommandLog::commit_loop, this);
+    }
+
+    DurableCommandLog(const DurableCommandLog&) = delete;
+    DurableCommandLog& operator=(const DurableCommandLog&) = delete;
+
+    // 提交并执行完所有已提交的命令后关闭
+    ~DurableCommandLog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        committer_.join();
+        ::close(fd_);
+    }
+
+    // 命令落盘并执行后 future 完成; 不可持久化的命令以异常形式报告
+    std::future<void> submit(const std::shared_ptr<Command>& command) {
+        Pending p;
+        p.command = command;
+        std::future<void> done = p.done.get_future();
+        std::string type = command ? command->type_name() : std::string();
+        if (type.empty()) {
+            p.done.set_exception(std::make_exception_ptr(
+                std::invalid_argument("command is not durable")));
+            return done;
+        }
+        std::string payload;
+        command->encode(payload);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        p.seq = next_seq_++;
+        std::string body;
+        wal::put(body, p.seq, 8);
+        wal::put(body, type.size(), 2);
+        body += type;
+        body += payload;
+        wal::put(p.record, body.size(), 4);
+        wal::put(p.record, wal::crc32(body.data(), body.size()), 4);
+        p.record += body;
+        pending_.push_back(std::move(p));
+        if (pending_.size() >= max_batch_) {
+            cv_.notify_all();
+        } else if (pending_.size() == 1) {
+            cv_.notify_one();
+        }
+        return done;
+    }
+
+    // 记录已执行的最大序号并清空日志, 重启后不再重放这些命令
+    void checkpoint() {
+        std::lock_guard<std::mutex> log_lock(log_mutex_);
+        if (failed_) {
+            std::rethrow_exception(failed_);
+        }
+        std::string data;
+        wal::put(data, applied_seq_, 8);
+        std::string tmp = checkpoint_path_ + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("cannot write checkpoint " + tmp);
+        }
+        bool ok = ::write(fd, data.data(), data.size()) ==
+                      static_cast<ssize_t>(data.size()) &&
+                  wal::sync(fd);
+        ::close(fd);
+        if (!ok || std::rename(tmp.c_str(), checkpoint_path_.c_str()) != 0) {
+            throw std::runtime_error("cannot write checkpoint " + tmp);
+        }
+        if (ftruncate(fd_, 0) != 0 || !wal::sync(fd_)) {
+            failed_ = std::make_exception_ptr(
+                std::runtime_error("cannot truncate command log " + path_));
+            std::rethrow_exception(failed_);
+        }
+        log_size_ = 0;
+    }
+
+    // 构造时重放的命令数
+    std::size_t replayed() const {
+        return replayed_;
+    }
+
+    // 已执行的 fsync 次数
+    std::size_t syncs() const {
+        return syncs_.load();
+    }
+};
+
+// 计数命令, 用于测量日志吞吐
+class CounterCommand : public Command {
+private:
+    std::atomic<long long>& counter_;
+    long long delta_;
+
+public:
+    CounterCommand(std::atomic<long long>& counter, long long delta) :
+        counter_(counter), delta_(delta) {
+    }
+
+    void execute() const override {
+        counter_.fetch_add(delta_);
+    }
+
+    std::string type_name() const override {
+        return "Counter";
+    }
+
+    void encode(std::string& out) const override {
+        out = std::to_string(delta_);
+    }
+};
+
+// 不同组提交批量下每秒可持久化提交的命令数
+void wal_benchmark(std::size_t n) {
+    std::atomic<long long> counter{ 0 };
+    CommandCodec codec;
+    const std::string path = wal::temp_path("command_bench");
+    for (std::size_t batch: { 1, 8, 64, 512 }) {
+        std::remove(path.c_str());
+        std::remove((path + ".ckpt").c_str());
+        auto command = std::make_shared<CounterCommand>(counter, 1);
+        auto start = std::chrono::steady_clock::now();
+        std::size_t syncs = 0;
+        {
+            DurableCommandLog log(path, codec, batch);
+            std::vector<std::future<void>> done;
+            done.reserve(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                done.push_back(log.submit(command));
+            }
+            for (std::future<void>& f: done) {
+                f.get();
+            }
+            syncs = log.syncs();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(stop - start).count();
+        std::cout << "batch " << batch << ": " << n / seconds
+                  << " commits/s, " << syncs << " fsyncs" << std::endl;
+    }
+    std::remove(path.c_str());
+    std::remove((path + ".ckpt").c_str());
+}
+#endif
+
 int main(int argc, char* argv[]) {
     // 创建接收者
     std::vector<std::shared_ptr<Reciever>> receivers = {
@@ -158,5 +1689,92 @@ int main(int argc, char* argv[]) {
     invoke.set_command(command);
     invoke.invoke();
 
+    // 通过执行服务异步执行命令
+    {
+        CommandExecutor executor(2, 64);
+        std::vector<std::future<void>> done;
+        for (int i = 0; i < 3; ++i) {
+            done.push_back(executor.submit(command));
+        }
+        for (std::future<void>& f: done) {
+            f.get();
+        }
+        print_stats(executor.stats());
+    }
+
+    // 扇出: 接收者在共享线程池上并行执行, 执行结束时等待全部完成
+    {
+        auto pool = std::make_shared<CommandExecutor>(3);
+        auto broadcast = std::make_shared<CommandA>(receivers);
+        broadcast->set_fan_out(pool, FanOutOrder::Barrier);
+        broadcast->execute();
+    }
+
+    fan_out_benchmark();
+
+    scheduler_benchmark();
+
+    // 撤销/重做: 连续输入合并为一条历史
+    TextDocument doc;
+    CommandHistory history(doc, 4096);
+    for (char c: std::string("hello")) {
+        history.execute(EditCommand::insert(doc, doc.text().size(),
+                                            std::string(1, c)));
+    }
+    history.execute(EditCommand::insert(doc, 0, ">> "));
+    history.execute(EditCommand::erase(doc, 3, 1));
+    std::cout << doc.text() << " (" << history.size() << " entries)"
+              << std::endl;
+    history.undo();
+    history.undo();
+    std::cout << doc.text() << std::endl;
+    history.redo();
+    std::cout << doc.text() << std::endl;
+
+    history_benchmark(1 << 20, 100000);
+
+#if COMMAND_HAS_WAL
+    // 持久化执行: 命令落盘后执行, 重启时重放检查点之后的命令
+    CommandCodec codec;
+    codec.add("CommandA", [&receivers](const std::string& payload) {
+        std::vector<std::shared_ptr<Reciever>> bound;
+        std::size_t begin = 0;
+        while (begin <= payload.size()) {
+            std::size_t end = payload.find(',', begin);
+            if (end == std::string::npos) {
+                end = payload.size();
+            }
+            std::string name = payload.substr(begin, end - begin);
+            for (const auto& receiver: receivers) {
+                if (name == receiver->name()) {
+                    bound.push_back(receiver);
+                }
+            }
+            begin = end + 1;
+        }
+        return std::make_shared<CommandA>(bound);
+    });
+
+    const std::string wal_path = wal::temp_path("command");
+    {
+        DurableCommandLog log(wal_path, codec);
+        log.submit(command).get();
+        log.checkpoint();
+        auto single = std::make_shared<CommandA>(
+            std::vector<std::shared_ptr<Reciever>>{ receivers[1] });
+        log.submit(single).get();
+    }
+    {
+        // 检查点之后只有一条命令需要重放
+        DurableCommandLog log(wal_path, codec);
+        std::cout << "replayed " << log.replayed() << " command(s)"
+                  << std::endl;
+    }
+    std::remove(wal_path.c_str());
+    std::remove((wal_path + ".ckpt").c_str());
+
+    wal_benchmark(2000);
+#endif
+
     return 0;
 }
@@ -27,9 +27,35 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <random>
+#include <streambuf>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TIMING_HAS_TSC 1
+#else
+#define TIMING_HAS_TSC 0
+#endif
 
 /**
  * 装饰器模式的用途：
@@ -56,7 +82,20 @@
  *    - 持有一个 `std::shared_ptr<Component>` 对象, 并通过 `Decorator::operation` 调用被装饰对象的功能. 
  * 4. `ConcreteDecorator1` 和 `ConcreteDecorator2`：
  *    - 在调用基类功能的基础上, 添加自己的装饰逻辑(如增加状态或功能). 
- * 5. 主函数中：
+ *    - 增加的状态在构造时确定且不可变, 输出写入 `BufferedSink`, 
+ *      `operation()` 的热路径上没有堆分配和系统调用. 
+ * 5. `Pipeline` 与 `StaticDecorator`：
+ *    - `Pipeline` 把运行时的装饰链编译为一段连续的预解析调用数组, 
+ *      一次遍历完成请求; 
+ *    - 装饰链在编译期已知时, 用 `StaticDecorator` 模板组合成一个类型, 
+ *      各层可被内联. 
+ * 6. `TimingDecorator`：
+ *    - 包装任意组件, 把 `operation()` 的耗时记入按线程分片的无锁
+ *      HDR 风格直方图, 按需合并; 可放在链中任意深度, 关闭后几乎没有开销. 
+ * 7. `CachingDecorator`：
+ *    - 为带输入的 `QueryComponent` 缓存结果: 分片的有界 LRU、
+ *      可配置的键与过期时间, 同一个键的并发请求合并为一次对被装饰组件的调用. 
+ * 8. 主函数中：
  *    - 创建未装饰的 `ConcreteComponent` 对象. 
  *    - 用具体装饰器 `ConcreteDecorator1` 和 `ConcreteDecorator2` 包装这些对象, 并调用装饰后的功能. 
  *
@@ -76,18 +115,195 @@
  */
 
 
+// 只统计当前线程在 AllocationScope 存续期间的堆分配, 计时与缓存基准中
+// 其他线程的分配不会混入 operation() 的计数. thread_local 指针为常量初始化,
+// 在 operator new 中访问不会触发动态初始化或再次分配.
+namespace alloc_count {
+inline thread_local std::size_t* active = nullptr;
+}
+
+class AllocationScope {
+private:
+    std::size_t count = 0;
+    std::size_t* previous;
+
+public:
+    AllocationScope() : previous(alloc_count::active) {
+        alloc_count::active = &count;
+    }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    ~AllocationScope() {
+        alloc_count::active = previous;
+    }
+
+    std::size_t allocations() const {
+        return count;
+    }
+};
+
+// 替换的 new/delete 保持为独立函数, 内联后 GCC 会误报 -Wmismatched-new-delete
+#if defined(__GNUC__) || defined(__clang__)
+#define ALLOC_COUNT_NOINLINE __attribute__((noinline))
+#else
+#define ALLOC_COUNT_NOINLINE
+#endif
+
+ALLOC_COUNT_NOINLINE void* operator new(std::size_t size) {
+    if (std::size_t* counter = alloc_count::active) {
+        ++*counter;
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+ALLOC_COUNT_NOINLINE void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+ALLOC_COUNT_NOINLINE void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// 带固定缓冲区的输出端: 写入只是内存拷贝, 缓冲区写满或显式 flush 时
+// 才整块写到目标流, 避免每次输出都 std::endl 刷新.
+// 默认不加锁, 只能由一个线程使用; shared 为 true 时每次写入加锁, 并挂到
+// 目标流的 tie() 上: 目标流每次输出前先写出缓冲内容, 直接写目标流的
+// 输出因此不会越过仍在缓冲区中的内容.
+class BufferedSink {
+private:
+    // 目标流通过 tie() 刷新它时调用 sync()
+    class TieHook : public std::streambuf {
+    private:
+        BufferedSink& sink;
+
+    protected:
+        int sync() override {
+            sink.flush();
+            return 0;
+        }
+
+    public:
+        explicit TieHook(BufferedSink& sink) : sink(sink) {
+        }
+    };
+
+    std::ostream& target;
+    const bool shared;
+    std::mutex mutex;
+    TieHook hook{ *this };
+    std::ostream hook_stream{ &hook };
+    char buffer[4096];
+    std::size_t used = 0;
+    std::size_t flushes = 0;
+
+    // 直接写目标流的 streambuf: 不构造 sentry, 因而不会经 tie() 回到本对象
+    void flush_locked() {
+        if (used) {
+            target.rdbuf()->sputn(buffer, static_cast<std::streamsize>(used));
+            target.rdbuf()->pubsync();
+            used = 0;
+            ++flushes;
+        }
+    }
+
+public:
+    explicit BufferedSink(std::ostream& target, bool shared = false) :
+        target(target), shared(shared) {
+        if (shared) {
+            target.tie(&hook_stream);
+        }
+    }
+
+    BufferedSink(const BufferedSink&) = delete;
+    BufferedSink& operator=(const BufferedSink&) = delete;
+
+    ~BufferedSink() {
+        if (target.tie() == &hook_stream) {
+            target.tie(nullptr);
+        }
+        flush();
+    }
+
+    void write(std::string_view text) {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (shared) {
+            lock.lock();
+        }
+        if (used + text.size() > sizeof(buffer)) {
+            flush_locked();
+            if (text.size() > sizeof(buffer)) { // 超大输出直接写出
+                target.rdbuf()->sputn(
+                    text.data(), static_cast<std::streamsize>(text.size()));
+                ++flushes;
+                return;
+            }
+        }
+        std::memcpy(buffer + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (shared) {
+            lock.lock();
+        }
+        flush_locked();
+    }
+
+    // 实际写到目标流的次数
+    std::size_t flush_count() const {
+        return flushes;
+    }
+
+    // 默认输出到标准输出, 可被多个线程共用, 与直接写 std::cout 的输出保持顺序
+    static BufferedSink& standard() {
+        static BufferedSink sink(std::cout, true);
+        return sink;
+    }
+};
+
+// 扁平化流水线中的一步: 预先解析好的函数指针及其作用对象
+struct Stage {
+    void (*run)(void* self);
+    void* self;
+};
+
+// 把成员函数绑定为一步, 调用时只有一次函数指针跳转
+template <class T, void (T::*Method)()>
+Stage make_stage(T* self) {
+    return { [](void* p) { (static_cast<T*>(p)->*Method)(); }, self };
+}
+
 // 抽象接口
 class Component {
 public:
     virtual ~Component() = default; // 虚析构函数
     virtual void operation() = 0;
+
+    // 把自身(及被装饰的对象)展开为按执行顺序排列的步骤.
+    // 默认把整个 operation() 当作一步, 未适配的组件也能正确展开
+    virtual void compile(std::vector<Stage>& stages) {
+        stages.push_back(make_stage<Component, &Component::operation>(this));
+    }
 };
 
 // 未装饰的基本实现
 class ConcreteComponent : public Component {
+private:
+    BufferedSink& sink;
+
 public:
+    explicit ConcreteComponent(BufferedSink& sink = BufferedSink::standard()) :
+        sink(sink) {
+    }
+
     void operation() override {
-        std::cout << "ConcreteComponent operation" << std::endl;
+        sink.write("ConcreteComponent operation\n");
     }
 };
 
@@ -96,6 +312,13 @@ class Decorator : public Component {
 protected:
     std::shared_ptr<Component> component; // 被装饰的对象
 
+    // 展开被装饰的对象, 供子类在其后追加自己的步骤
+    void compile_component(std::vector<Stage>& stages) {
+        if (component) {
+            component->compile(stages);
+        }
+    }
+
 public:
     explicit Decorator(std::shared_ptr<Component> c) : component(c) {
     }
@@ -110,43 +333,934 @@ public:
 // 具体装饰器1
 class ConcreteDecorator1 : public Decorator {
 private:
-    std::string added_state_; // 增加的状态
+    const std::string added_state_; // 增加的状态, 构造后不再改变
+    const std::string line_;        // 预先拼好的输出
+    BufferedSink& sink;
 
 public:
-    explicit ConcreteDecorator1(std::shared_ptr<Component> component) :
-        Decorator(component) {
+    explicit ConcreteDecorator1(std::shared_ptr<Component> component,
+                                std::string added_state = "added state 1",
+                                BufferedSink& sink = BufferedSink::standard()) :
+        Decorator(component), added_state_(std::move(added_state)),
+        line_("ConcreteDecorator1 added_state: " + added_state_ + "\n"),
+        sink(sink) {
+    }
+
+    const std::string& added_state() const {
+        return added_state_;
     }
 
     void operation() override {
         Decorator::operation(); // 装饰前
-        added_state_ = "added state 1";
+        decorate();
+    }
+
+    void compile(std::vector<Stage>& stages) override {
+        compile_component(stages);
+        using Self = ConcreteDecorator1;
+        stages.push_back(make_stage<Self, &Self::decorate>(this));
+    }
 
+private:
+    // 装饰逻辑, 嵌套调用与扁平化流水线共用
+    void decorate() {
         // 装饰后
-        std::cout << "ConcreteDecorator1 added_state: " << added_state_
-                  << std::endl;
+        sink.write(line_);
     }
 };
 
 // 具体装饰器2
 class ConcreteDecorator2 : public Decorator {
 private:
-    std::string added_state_; // 增加的状态
+    const std::string added_state_; // 增加的状态, 构造后不再改变
+    const std::string line_;        // 预先拼好的输出
+    BufferedSink& sink;
 
 public:
-    explicit ConcreteDecorator2(std::shared_ptr<Component> component) :
-        Decorator(component) {
+    explicit ConcreteDecorator2(std::shared_ptr<Component> component,
+                                std::string added_state = "added state 2",
+                                BufferedSink& sink = BufferedSink::standard()) :
+        Decorator(component), added_state_(std::move(added_state)),
+        line_("ConcreteDecorator2 added_state: " + added_state_ + "\n"),
+        sink(sink) {
+    }
+
+    const std::string& added_state() const {
+        return added_state_;
     }
 
     void operation() override {
         Decorator::operation(); // 装饰前
-        added_state_ = "added state 2";
+        decorate();
+    }
+
+    void compile(std::vector<Stage>& stages) override {
+        compile_component(stages);
+        using Self = ConcreteDecorator2;
+        stages.push_back(make_stage<Self, &Self::decorate>(this));
+    }
 
+private:
+    // 装饰逻辑, 嵌套调用与扁平化流水线共用
+    void decorate() {
         // 装饰后
-        std::cout << "ConcreteDecorator2 added_state: " << added_state_
-                  << std::endl;
+        sink.write(line_);
+    }
+};
+
+// 扁平化的装饰链: 构造时展开一次, 之后每个请求顺序执行连续数组中的步骤,
+// 不再逐层虚调用与追踪 shared_ptr. 流水线不持有组件, 组件需比流水线活得久
+class Pipeline {
+private:
+    std::vector<Stage> stages;
+
+public:
+    explicit Pipeline(Component& component) {
+        component.compile(stages);
+    }
+
+    void operation() const {
+        for (const Stage& stage: stages) {
+            stage.run(stage.self);
+        }
+    }
+
+    std::size_t size() const {
+        return stages.size();
+    }
+};
+
+// 静态装饰器: 装饰链在编译期已知时, 被装饰对象与装饰步骤都按值保存,
+// 整条链是一个类型, 编译器可以把各层内联为一次直线执行
+template <class Inner, class Step>
+class StaticDecorator {
+private:
+    Inner inner;
+    Step step;
+
+public:
+    StaticDecorator(Inner inner, Step step) :
+        inner(std::move(inner)), step(std::move(step)) {
+    }
+
+    void operation() {
+        inner.operation();
+        step();
+    }
+};
+
+// 低开销计时: x86 上直接读取 TSC, 其他平台退回 steady_clock.
+// 直方图记录原始计数, 只在汇报时按校准出的频率换算为纳秒
+namespace timing {
+inline std::uint64_t now_ticks() {
+#if TIMING_HAS_TSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// 每纳秒的计数值, 首次调用时用 steady_clock 校准约 10ms
+inline double ticks_per_ns() {
+    static const double ratio = [] {
+#if TIMING_HAS_TSC
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t begin = now_ticks();
+        while (std::chrono::steady_clock::now() - start <
+               std::chrono::milliseconds(10)) {
+        }
+        std::uint64_t ticks = now_ticks() - begin;
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(ticks) /
+               std::chrono::duration<double, std::nano>(elapsed).count();
+#else
+        return 1e9 * std::chrono::steady_clock::period::num /
+               std::chrono::steady_clock::period::den;
+#endif
+    }();
+    return ratio;
+}
+
+inline double to_ns(std::uint64_t ticks) {
+    return static_cast<double>(ticks) / ticks_per_ns();
+}
+}
+
+// HDR 风格的对数-线性直方图: 每个 2 的幂区间再均分为 16 个子桶,
+// 任意值的相对误差不超过 1/16, 桶数固定, 记录只需一次下标计算
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 4;
+    static constexpr std::size_t kSubBuckets = std::size_t(1) << kSubBits;
+    static constexpr std::size_t kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    static std::size_t index_of(std::uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<std::size_t>(value);
+        }
+#if defined(__GNUC__) || defined(__clang__)
+        int msb = 63 - __builtin_clzll(value);
+#else
+        int msb = 0;
+        while (value >> (msb + 1)) {
+            ++msb;
+        }
+#endif
+        int shift = msb - kSubBits;
+        return (shift + 1) * kSubBuckets +
+               static_cast<std::size_t>((value >> shift) & (kSubBuckets - 1));
+    }
+
+    // 桶内的最小值
+    static std::uint64_t value_at(std::size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        std::size_t shift = index / kSubBuckets - 1;
+        return (kSubBuckets + index % kSubBuckets) << shift;
+    }
+
+private:
+    std::vector<std::uint64_t> counts = std::vector<std::uint64_t>(kBuckets);
+    std::uint64_t total = 0;
+    std::uint64_t max_value = 0;
+
+public:
+    void record(std::uint64_t value, std::uint64_t n = 1) {
+        counts[index_of(value)] += n;
+        total += n;
+        merge_max(value);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        merge_max(other.max_value);
+    }
+
+    // 并入在别处精确记录的最大值
+    void merge_max(std::uint64_t value) {
+        max_value = std::max(max_value, value);
+    }
+
+    std::uint64_t count() const {
+        return total;
+    }
+
+    // 记录过的最大值, 是精确值而不是所在桶的下界
+    std::uint64_t max() const {
+        return max_value;
+    }
+
+    // 第 q (0~1) 分位所在桶的下界
+    std::uint64_t percentile(double q) const {
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = static_cast<std::uint64_t>(q * (total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return value_at(i);
+            }
+        }
+        return value_at(kBuckets - 1);
+    }
+};
+
+// 无锁的按线程分片直方图: 同时存活的前 kShards 个记录线程各自独占一个
+// 分片, 记录只是对本线程缓存行的 relaxed 读与写, 不需要带总线锁的原子
+// 自增; 其余线程共用一个溢出分片, 以原子自增保证计数正确. 线程退出时
+// 把编号放回空闲表, 线程池换血后新线程仍能拿到独占分片.
+// 分片首次使用时通过 CAS 惰性创建, 每个分片另外记录精确的最大值
+class ConcurrentHistogram {
+public:
+    static constexpr std::size_t kShards = 64;
+
+private:
+    struct Shard {
+        std::atomic<std::uint64_t> counts[LatencyHistogram::kBuckets] = {};
+        std::atomic<std::uint64_t> max{ 0 };
+    };
+
+    // 线程编号的分配表, 在所有直方图间共用
+    struct SlotPool {
+        std::mutex mutex;
+        std::size_t next = 0;
+        std::vector<std::size_t> free;
+    };
+
+    // 线程退出时归还独占的编号. 归还与再分配都经过 SlotPool 的互斥锁,
+    // 接手的线程能看到前一个线程写入的计数; 之后本线程若还有记录
+    // (例如来自其他 thread_local 的析构函数)则改用溢出分片
+    struct SlotLease {
+        std::size_t& slot;
+
+        ~SlotLease() {
+            if (slot < kShards) {
+                SlotPool& pool = slot_pool();
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                pool.free.push_back(slot);
+            }
+            slot = kShards;
+        }
+    };
+
+    std::atomic<Shard*> shards[kShards + 1] = {}; // 最后一个为溢出分片
+
+    static SlotPool& slot_pool() {
+        static SlotPool pool;
+        return pool;
+    }
+
+    static std::size_t acquire_slot() {
+        SlotPool& pool = slot_pool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (!pool.free.empty()) {
+            std::size_t slot = pool.free.back();
+            pool.free.pop_back();
+            return slot;
+        }
+        return pool.next < kShards ? pool.next++ : kShards;
+    }
+
+    // 常量初始化的 thread_local 访问时不需要初始化检查, 只有首次记录时
+    // 才登记负责归还的 SlotLease; 编号 kShards 表示溢出分片
+    static std::size_t thread_slot() {
+        thread_local std::size_t slot = kShards + 1; // 尚未分配
+        if (slot > kShards) {
+            slot = acquire_slot();
+            thread_local SlotLease lease{ slot };
+            (void)lease;
+        }
+        return slot;
+    }
+
+    Shard& shard_at(std::size_t slot) {
+        std::atomic<Shard*>& entry = shards[slot];
+        Shard* shard = entry.load(std::memory_order_acquire);
+        if (!shard) {
+            auto* created = new Shard();
+            if (entry.compare_exchange_strong(shard, created,
+                                              std::memory_order_acq_rel)) {
+                shard = created;
+            } else {
+                delete created; // 共用溢出分片的其他线程已创建
+            }
+        }
+        return *shard;
+    }
+
+public:
+    ConcurrentHistogram() = default;
+    ConcurrentHistogram(const ConcurrentHistogram&) = delete;
+    ConcurrentHistogram& operator=(const ConcurrentHistogram&) = delete;
+
+    ~ConcurrentHistogram() {
+        for (auto& entry: shards) {
+            delete entry.load(std::memory_order_relaxed);
+        }
+    }
+
+    void record(std::uint64_t value) {
+        std::size_t slot = thread_slot();
+        Shard& shard = shard_at(slot);
+        std::atomic<std::uint64_t>& count =
+            shard.counts[LatencyHistogram::index_of(value)];
+        std::uint64_t max = shard.max.load(std::memory_order_relaxed);
+        if (slot < kShards) {
+            count.store(count.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+            if (value > max) {
+                shard.max.store(value, std::memory_order_relaxed);
+            }
+            return;
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+        while (value > max &&
+               !shard.max.compare_exchange_weak(max, value,
+                                                std::memory_order_relaxed)) {
+        }
+    }
+
+    // 按需合并所有分片, 可以与记录并发进行
+    LatencyHistogram snapshot() const {
+        LatencyHistogram merged;
+        for (const auto& entry: shards) {
+            const Shard* shard = entry.load(std::memory_order_acquire);
+            if (!shard) {
+                continue;
+            }
+            for (std::size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+                std::uint64_t n =
+                    shard->counts[i].load(std::memory_order_relaxed);
+                if (n) {
+                    merged.record(LatencyHistogram::value_at(i), n);
+                }
+            }
+            merged.merge_max(shard->max.load(std::memory_order_relaxed));
+        }
+        return merged;
+    }
+};
+
+// 计时装饰器: 包装任意 Component, 把每次 operation() 的耗时记入直方图.
+// 可以插在链中任意深度, 从而得到每一层(含其内部各层)的延迟分布.
+// 关闭时嵌套调用只多一次 relaxed 读, 展开为流水线时完全不产生步骤.
+// 开启时每次调用的主要开销是两次读时钟, 在 rdtsc 被虚拟化的环境中
+// 单次读取就需要二三十纳秒, 远高于直方图记录本身
+class TimingDecorator final : public Decorator {
+private:
+    // 展开为流水线时, 被装饰部分编译为一段子流水线, 由一个步骤在局部变量中
+    // 保存开始时间并依次执行: 嵌套深度不受限制, 某一步抛出异常也不会留下
+    // 未配对的开始时间. 段由装饰器持有且地址稳定, 每次编译追加一段
+    struct Section {
+        TimingDecorator* owner;
+        std::vector<Stage> stages;
+    };
+
+    std::string name_;
+    std::atomic<bool> enabled_{ true };
+    ConcurrentHistogram histogram_;
+    std::mutex sections_mutex_;
+    std::list<Section> sections_;
+
+    static void run_section(void* self) {
+        const Section& section = *static_cast<const Section*>(self);
+        std::uint64_t start = timing::now_ticks();
+        for (const Stage& stage: section.stages) {
+            stage.run(stage.self);
+        }
+        section.owner->histogram_.record(timing::now_ticks() - start);
+    }
+
+public:
+    TimingDecorator(std::shared_ptr<Component> component, std::string name) :
+        Decorator(std::move(component)), name_(std::move(name)) {
+    }
+
+    void operation() override {
+        if (!enabled_.load(std::memory_order_relaxed)) {
+            Decorator::operation();
+            return;
+        }
+        std::uint64_t start = timing::now_ticks();
+        Decorator::operation();
+        histogram_.record(timing::now_ticks() - start);
+    }
+
+    void compile(std::vector<Stage>& stages) override {
+        if (!enabled_.load(std::memory_order_relaxed)) {
+            compile_component(stages);
+            return;
+        }
+        Section* section = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(sections_mutex_);
+            sections_.push_back(Section{ this, {} });
+            section = &sections_.back();
+        }
+        compile_component(section->stages);
+        stages.push_back(Stage{ &TimingDecorator::run_section, section });
+    }
+
+    // 已编译的流水线不受影响, 需要重新编译
+    void set_enabled(bool enabled) {
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    const std::string& name() const {
+        return name_;
+    }
+
+    // 合并各线程分片得到的直方图, 单位为计时计数
+    LatencyHistogram histogram() const {
+        return histogram_.snapshot();
+    }
+
+    void report(std::ostream& os) const {
+        LatencyHistogram h = histogram();
+        os << "  " << name_ << ": " << h.count() << " calls, p50 "
+           << timing::to_ns(h.percentile(0.5)) << " ns, p99 "
+           << timing::to_ns(h.percentile(0.99)) << " ns, p99.9 "
+           << timing::to_ns(h.percentile(0.999)) << " ns, max "
+           << timing::to_ns(h.max()) << " ns" << std::endl;
+    }
+};
+
+// 带输入与结果的组件: 装饰器可以按请求区分调用, operation() 使用默认请求
+template <class Request, class Result>
+class QueryComponent : public Component {
+public:
+    virtual Result query(const Request& request) = 0;
+
+    void operation() override {
+        query(Request{});
+    }
+};
+
+// 缓存与请求合并装饰器: 结果按键缓存在分片的有界 LRU 中并带过期时间;
+// 同一个键的并发未命中只有第一个调用真正执行被装饰组件,
+// 其余调用等待并共享它的结果(single-flight)
+template <class Request, class Result, class Key = Request>
+class CachingDecorator : public QueryComponent<Request, Result> {
+public:
+    using Inner = QueryComponent<Request, Result>;
+    using KeyFunction = std::function<Key(const Request&)>;
+    using Duration = std::chrono::steady_clock::duration;
+
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;    // 真正调用被装饰组件的次数
+        std::size_t coalesced = 0; // 等待其他调用结果的次数
+        std::size_t evictions = 0;
+    };
+
+private:
+    static constexpr std::size_t kShards = 16;
+
+    struct Entry {
+        Key key;
+        Result result;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru; // 最近使用的在前
+        std::unordered_map<Key, typename std::list<Entry>::iterator> index;
+        std::unordered_map<Key, std::shared_future<Result>> in_flight;
+    };
+
+    std::shared_ptr<Inner> inner;
+    KeyFunction key_of;
+    std::size_t shard_count;             // 容量小于 kShards 时只用前几个分片
+    std::size_t shard_capacity[kShards]; // 各分片容量之和等于总容量
+    Duration ttl;
+    Shard shards[kShards];
+    std::atomic<std::size_t> hits{ 0 };
+    std::atomic<std::size_t> misses{ 0 };
+    std::atomic<std::size_t> coalesced{ 0 };
+    std::atomic<std::size_t> evictions{ 0 };
+
+    // 在持有分片锁时插入结果, 超出容量淘汰最久未用的条目
+    void store(Shard& shard, const Key& key, const Result& result) {
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+            shard.lru.erase(found->second);
+            shard.index.erase(found);
+        }
+        shard.lru.push_front(
+            { key, result, std::chrono::steady_clock::now() + ttl });
+        shard.index[key] = shard.lru.begin();
+        std::size_t capacity = shard_capacity[&shard - shards];
+        while (shard.lru.size() > capacity) {
+            shard.index.erase(shard.lru.back().key);
+            shard.lru.pop_back();
+            evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    // capacity 为所有分片合计的条目上限(至少为 1), 余数分给前几个分片;
+    // key_of 为空时直接以请求作为键
+    CachingDecorator(std::shared_ptr<Inner> inner, std::size_t capacity,
+                     Duration ttl, KeyFunction key_of = nullptr) :
+        inner(std::move(inner)), key_of(std::move(key_of)), ttl(ttl) {
+        capacity = std::max<std::size_t>(capacity, 1);
+        shard_count = std::min(capacity, kShards);
+        std::size_t base = capacity / shard_count;
+        std::size_t remainder = capacity % shard_count;
+        for (std::size_t i = 0; i < kShards; ++i) {
+            shard_capacity[i] = i < shard_count ? base + (i < remainder) : 0;
+        }
+        if (!this->key_of) {
+            this->key_of = [](const Request& request) { return Key(request); };
+        }
+    }
+
+    Result query(const Request& request) override {
+        Key key = key_of(request);
+        Shard& shard = shards[std::hash<Key>()(key) % shard_count];
+        std::unique_lock<std::mutex> lock(shard.mutex);
+
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+            if (found->second->expires > std::chrono::steady_clock::now()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return found->second->result;
+            }
+            shard.lru.erase(found->second); // 已过期
+            shard.index.erase(found);
+        }
+
+        auto flight = shard.in_flight.find(key);
+        if (flight != shard.in_flight.end()) {
+            std::shared_future<Result> pending = flight->second;
+            lock.unlock();
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+            return pending.get();
+        }
+
+        std::promise<Result> promise;
+        shard.in_flight.emplace(key, promise.get_future().share());
+        lock.unlock();
+        misses.fetch_add(1, std::memory_order_relaxed);
+
+        try {
+            Result result = inner->query(request);
+            lock.lock();
+            store(shard, key, result);
+            shard.in_flight.erase(key);
+            lock.unlock();
+            promise.set_value(result);
+            return result;
+        } catch (...) {
+            // 失败不缓存, 等待者收到同一个异常; store 抛出时锁仍被持有
+            if (!lock.owns_lock()) {
+                lock.lock();
+            }
+            shard.in_flight.erase(key);
+            lock.unlock();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    Stats stats() const {
+        Stats s;
+        s.hits = hits.load(std::memory_order_relaxed);
+        s.misses = misses.load(std::memory_order_relaxed);
+        s.coalesced = coalesced.load(std::memory_order_relaxed);
+        s.evictions = evictions.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+// 丢弃所有输出的流缓冲区, 用于只测量装饰器本身的开销
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        return n;
+    }
+};
+
+// 统计装饰链 operation() 的堆分配次数和写出次数
+void allocation_demo(std::size_t calls) {
+    NullBuffer discard;
+    std::ostream null_stream(&discard);
+    BufferedSink sink(null_stream);
+    std::shared_ptr<Component> chain = std::make_shared<ConcreteDecorator2>(
+        std::make_shared<ConcreteDecorator1>(
+            std::make_shared<ConcreteComponent>(sink), "added state 1", sink),
+        "added state 2", sink);
+
+    chain->operation(); // 预热
+    std::size_t allocs = 0;
+    std::size_t flushes = sink.flush_count();
+    auto start = std::chrono::steady_clock::now();
+    {
+        AllocationScope scope;
+        for (std::size_t i = 0; i < calls; ++i) {
+            chain->operation();
+        }
+        allocs = scope.allocations();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink.flush();
+
+    std::cout << "operation(): " << static_cast<double>(allocs) / calls
+              << " allocs/call" << (allocs ? " (EXPECTED NONE)" : "") << ", "
+              << sink.flush_count() - flushes << " writes for " << calls
+              << " calls (" << 3 * calls << " with std::endl), "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     calls
+              << " ns/call" << std::endl;
+}
+
+// 基准测试用的轻量组件与装饰器, 每一步只做一次依赖上一步结果的运算
+class CountingComponent final : public Component {
+private:
+    std::uint64_t* total;
+
+public:
+    explicit CountingComponent(std::uint64_t* total) : total(total) {
+    }
+
+    void operation() override {
+        *total = *total * 31 + 1;
+    }
+
+    void compile(std::vector<Stage>& stages) override {
+        stages.push_back(
+            make_stage<CountingComponent, &CountingComponent::operation>(this));
+    }
+};
+
+struct CountStep {
+    std::uint64_t* total;
+    std::uint64_t amount;
+
+    void operator()() const {
+        *total = *total * 31 + amount;
+    }
+};
+
+class CountingDecorator final : public Decorator {
+private:
+    CountStep step;
+
+public:
+    CountingDecorator(std::shared_ptr<Component> component, CountStep step) :
+        Decorator(std::move(component)), step(step) {
+    }
+
+    void operation() override {
+        Decorator::operation();
+        count();
+    }
+
+    void compile(std::vector<Stage>& stages) override {
+        compile_component(stages);
+        stages.push_back(
+            make_stage<CountingDecorator, &CountingDecorator::count>(this));
+    }
+
+private:
+    void count() {
+        step();
+    }
+};
+
+template <std::size_t Depth>
+auto make_static_chain(std::uint64_t* total) {
+    if constexpr (Depth == 0) {
+        return CountingComponent(total);
+    } else {
+        return StaticDecorator<decltype(make_static_chain<Depth - 1>(total)),
+                               CountStep>(make_static_chain<Depth - 1>(total),
+                                          CountStep{ total, Depth + 1 });
+    }
+}
+
+// 同一条装饰链分别以嵌套虚调用、扁平流水线和静态组合执行, 比较每个请求的耗时
+template <std::size_t Depth>
+void chain_benchmark(std::size_t requests) {
+    using clock = std::chrono::steady_clock;
+    std::uint64_t totals[3] = { 0, 0, 0 };
+
+    std::shared_ptr<Component> nested =
+        std::make_shared<CountingComponent>(&totals[0]);
+    std::shared_ptr<Component> flat_root =
+        std::make_shared<CountingComponent>(&totals[1]);
+    for (std::size_t i = 1; i <= Depth; ++i) {
+        nested = std::make_shared<CountingDecorator>(
+            nested, CountStep{ &totals[0], i + 1 });
+        flat_root = std::make_shared<CountingDecorator>(
+            flat_root, CountStep{ &totals[1], i + 1 });
+    }
+    Pipeline pipeline(*flat_root);
+    auto chain = make_static_chain<Depth>(&totals[2]);
+
+    auto t0 = clock::now();
+    for (std::size_t i = 0; i < requests; ++i) {
+        nested->operation();
+    }
+    auto t1 = clock::now();
+    for (std::size_t i = 0; i < requests; ++i) {
+        pipeline.operation();
+    }
+    auto t2 = clock::now();
+    for (std::size_t i = 0; i < requests; ++i) {
+        chain.operation();
+    }
+    auto t3 = clock::now();
+
+    auto ns = [requests](clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() /
+               static_cast<double>(requests);
+    };
+    bool same = totals[0] == totals[1] && totals[1] == totals[2];
+    std::cout << "  depth " << Depth << ": nested " << ns(t1 - t0)
+              << " ns, pipeline " << ns(t2 - t1) << " ns, static "
+              << ns(t3 - t2) << " ns" << (same ? "" : " (MISMATCH)")
+              << std::endl;
+}
+
+template <std::size_t... Depths>
+void chain_benchmarks(std::size_t requests, std::index_sequence<Depths...>) {
+    std::cout << "decorator chains, " << requests << " requests:" << std::endl;
+    (chain_benchmark<Depths>(requests), ...);
+}
+
+// 线程安全的模拟负载: 每次 operation() 做固定次数的局部运算
+class BusyComponent final : public Component {
+private:
+    std::size_t work;
+    std::atomic<std::uint64_t> result{ 0 };
+
+public:
+    explicit BusyComponent(std::size_t work) : work(work) {
+    }
+
+    void operation() override {
+        std::uint64_t x = result.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < work; ++i) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+        result.store(x, std::memory_order_relaxed);
     }
 };
 
+// 计时装饰器的开销(开启/关闭)以及多线程下按层合并的延迟分布
+void timing_benchmark(std::size_t calls, std::size_t threads) {
+    using clock = std::chrono::steady_clock;
+    auto ns_per_call = [calls](clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() /
+               static_cast<double>(calls);
+    };
+
+    std::uint64_t total = 0;
+    auto plain = std::make_shared<CountingComponent>(&total);
+    auto timed = std::make_shared<TimingDecorator>(plain, "counting");
+    auto t0 = clock::now();
+    for (std::size_t i = 0; i < calls; ++i) {
+        plain->operation();
+    }
+    auto t1 = clock::now();
+    for (std::size_t i = 0; i < calls; ++i) {
+        timed->operation();
+    }
+    auto t2 = clock::now();
+    timed->set_enabled(false);
+    for (std::size_t i = 0; i < calls; ++i) {
+        timed->operation();
+    }
+    auto t3 = clock::now();
+    std::uint64_t ticks = 0;
+    for (std::size_t i = 0; i < calls; ++i) {
+        ticks += timing::now_ticks();
+    }
+    auto t4 = clock::now();
+    std::cout << "timing decorator: bare " << ns_per_call(t1 - t0)
+              << " ns, enabled " << ns_per_call(t2 - t1) << " ns, disabled "
+              << ns_per_call(t3 - t2) << " ns per call, clock read "
+              << ns_per_call(t4 - t3) << " ns (checksum " << (total ^ ticks)
+              << ")" << std::endl;
+
+    // 两层计时: 内层只测负载, 外层包含中间的装饰器
+    auto inner = std::make_shared<TimingDecorator>(
+        std::make_shared<BusyComponent>(64), "inner");
+    std::shared_ptr<Component> middle = inner;
+    for (std::size_t i = 0; i < 8; ++i) {
+        middle = std::make_shared<Decorator>(middle);
+    }
+    auto outer = std::make_shared<TimingDecorator>(middle, "outer");
+    Pipeline pipeline(*outer);
+
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (std::size_t i = 0; i < calls / threads; ++i) {
+                if (t % 2) {
+                    pipeline.operation();
+                } else {
+                    outer->operation();
+                }
+            }
+        });
+    }
+    for (std::thread& worker: workers) {
+        worker.join();
+    }
+    std::cout << "per-layer latency, " << threads << " threads:" << std::endl;
+    outer->report(std::cout);
+    inner->report(std::cout);
+}
+
+// 模拟昂贵的具体组件: 每次查询耗时固定, 并统计实际执行次数
+class ExpensiveComponent final : public QueryComponent<int, std::string> {
+private:
+    std::chrono::microseconds cost;
+    std::atomic<std::size_t> calls{ 0 };
+
+public:
+    explicit ExpensiveComponent(std::chrono::microseconds cost) : cost(cost) {
+    }
+
+    std::string query(const int& request) override {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::sleep_for(cost);
+        return "result " + std::to_string(request);
+    }
+
+    std::size_t call_count() const {
+        return calls.load(std::memory_order_relaxed);
+    }
+};
+
+// 多线程对偏斜分布的请求键查询, 比较直接调用与缓存合并后的耗时与实际调用次数
+void caching_benchmark(std::size_t threads, std::size_t queries,
+                       std::size_t keys) {
+    using clock = std::chrono::steady_clock;
+    auto run = [&](QueryComponent<int, std::string>& component) {
+        std::atomic<std::size_t> wrong{ 0 };
+        std::vector<std::thread> workers;
+        auto start = clock::now();
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::mt19937 rng(static_cast<unsigned>(t));
+                for (std::size_t i = 0; i < queries; ++i) {
+                    // 小键更常见
+                    int key = static_cast<int>(rng() % (1 + rng() % keys));
+                    std::string expected = "result " + std::to_string(key);
+                    if (component.query(key) != expected) {
+                        wrong.fetch_add(1);
+                    }
+                }
+            });
+        }
+        for (std::thread& worker: workers) {
+            worker.join();
+        }
+        return std::make_pair(
+            std::chrono::duration<double, std::milli>(clock::now() - start)
+                .count(),
+            wrong.load());
+    };
+
+    auto direct = std::make_shared<ExpensiveComponent>(
+        std::chrono::microseconds(500));
+    auto [direct_ms, direct_wrong] = run(*direct);
+
+    auto backend = std::make_shared<ExpensiveComponent>(
+        std::chrono::microseconds(500));
+    CachingDecorator<int, std::string> cached(backend, 64,
+                                              std::chrono::seconds(10));
+    auto [cached_ms, cached_wrong] = run(cached);
+    auto stats = cached.stats();
+
+    std::cout << "caching decorator: " << threads << " threads x " << queries
+              << " queries over " << keys << " keys" << std::endl
+              << "  direct: " << direct_ms << " ms, " << direct->call_count()
+              << " backend calls" << std::endl
+              << "  cached: " << cached_ms << " ms, " << backend->call_count()
+              << " backend calls, " << stats.hits << " hits, "
+              << stats.coalesced << " coalesced, " << stats.evictions
+              << " evictions"
+              << (direct_wrong + cached_wrong ? " (WRONG RESULTS)" : "")
+              << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     // 创被装饰的对象
     std::shared_ptr<Component> c1 = std::make_shared<ConcreteComponent>();
@@ -161,5 +1275,30 @@ int main(int argc, char* argv[]) {
     d1->operation();
     d2->operation();
 
+    // 把多层装饰链编译为一次遍历的流水线
+    std::shared_ptr<Component> d3 = std::make_shared<ConcreteDecorator2>(d1);
+    Pipeline pipeline(*d3);
+    std::cout << "pipeline with " << pipeline.size() << " stages:" << std::endl;
+    pipeline.operation();
+
+    allocation_demo(1000000);
+
+    chain_benchmarks(2000000, std::index_sequence<1, 2, 4, 8, 16, 32>());
+
+    timing_benchmark(2000000, 4);
+
+    // 缓存装饰器: 相同请求只计算一次, 过期后重新计算
+    auto backend = std::make_shared<ExpensiveComponent>(
+        std::chrono::microseconds(100));
+    CachingDecorator<int, std::string> cached(backend, 16,
+                                              std::chrono::milliseconds(20));
+    cached.query(1);
+    cached.query(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    std::cout << cached.query(1) << ": " << backend->call_count()
+              << " backend calls for 3 queries (1 expired)" << std::endl;
+
+    caching_benchmark(8, 200, 100);
+
     return 0;
 }
@@ -0,0 +1,71 @@
+/**
+ * @file factory_plugin.h
+ * @author wenshuyu (wsy2161826815@163.com)
+ * @brief 抽象工厂插件的 C ABI
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef _FACTORY_PLUGIN_H_
+#define _FACTORY_PLUGIN_H_
+
+#include <stdint.h>
+
+/**
+ * 以共享库形式提供的产品族.
+ * 插件只导出一个 C 函数 FACTORY_PLUGIN_ENTRY, 返回描述该产品族的函数表;
+ * 产品对象对宿主是不透明句柄, 由插件自己创建和销毁, 因此宿主与插件
+ * 可以使用不同的编译器或标准库. ABI 不兼容的修改需要提升版本号,
+ * 入口函数名也随之改变, 旧宿主不会误加载新插件.
+ *
+ * 插件文件按 lib<产品族名>.so 命名, 宿主据此在不加载库的前提下发现产品族.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FACTORY_PLUGIN_ABI_VERSION 1
+#define FACTORY_PLUGIN_ENTRY "factory_plugin_entry_v1"
+
+typedef struct FactoryPluginApi {
+    uint32_t abi_version; // 必须等于 FACTORY_PLUGIN_ABI_VERSION
+    const char* family;   // 产品族名, 与文件名一致
+
+    void* (*create_productA)(void);
+    void (*methodA)(const void* product);
+    void (*destroy_productA)(void* product);
+
+    void* (*create_productB)(void);
+    void (*methodB)(const void* product);
+    void (*destroy_productB)(void* product);
+} FactoryPluginApi;
+
+typedef const FactoryPluginApi* (*FactoryPluginEntry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FACTORY_PLUGIN_H_ */
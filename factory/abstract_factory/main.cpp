@@ -27,8 +27,28 @@
  *
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if __has_include(<dlfcn.h>)
+#include <dlfcn.h>
+#define FACTORY_HAS_PLUGINS 1
+#include "factory_plugin.h"
+#else
+#define FACTORY_HAS_PLUGINS 0
+#endif
 
 /**
  * 抽象工厂模式的用途：
@@ -49,6 +69,14 @@
  * - `AbstractProductA`和`AbstractProductB`分别定义了产品A和产品B的抽象接口. 
  * - `ProdunctA1`、`ProdunctA2`、`ProdunctB1`、`ProdunctB2`是具体的产品类. 
  * 客户端代码通过工厂对象创建产品, 而不关心具体的产品类, 从而实现了对产品族的解耦和扩展. 
+ * - 工厂也可以把产品创建在调用方提供的`std::pmr::memory_resource`中, 
+ *   配合`RequestArena`让一次请求的整族产品连续存放, 请求结束时整体释放. 
+ * - `create_productsA`/`create_productsB`一次创建 N 个同类型产品, 与批次对象一起
+ *   连续存放在一次分配的`ProductBatch`中; 具体工厂的`make_productsA`/`make_productsB`返回具体类型,
+ *   遍历时直接访问元素, 不经过指针和虚函数. 
+ * - `FactoryPluginRegistry`从目录中发现以共享库提供的产品族(见`factory_plugin.h`
+ *   与`plugin/family_plugin.cpp`), 首次请求某个产品族时才 dlopen 加载,
+ *   并记录每个插件的加载耗时. 
  */
 
 
@@ -60,7 +88,7 @@ public:
 };
 
 // 产品A1
-class ProdunctA1 : public AbstractProductA {
+class ProdunctA1 final : public AbstractProductA {
 public:
     void methodA() const override {
         std::cout << "ProdunctA1::methodA()" << std::endl;
@@ -68,7 +96,7 @@ public:
 };
 
 // 产品A2
-class ProdunctA2 : public AbstractProductA {
+class ProdunctA2 final : public AbstractProductA {
 public:
     void methodA() const override {
         std::cout << "ProdunctA2::methodA()" << std::endl;
@@ -83,7 +111,7 @@ public:
 };
 
 // 产品B1
-class ProdunctB1 : public AbstractProductB {
+class ProdunctB1 final : public AbstractProductB {
 public:
     void methodB() const override {
         std::cout << "ProdunctB1::methodB()" << std::endl;
@@ -91,21 +119,224 @@ public:
 };
 
 // 产品B2
-class ProdunctB2 : public AbstractProductB {
+class ProdunctB2 final : public AbstractProductB {
 public:
     void methodB() const override {
         std::cout << "ProdunctB2::methodB()" << std::endl;
     }
 };
 
+// 析构在 memory_resource 中创建的产品并把内存交还给它.
+// 对单调(arena)资源而言 deallocate 为空操作, 内存在 arena 释放时统一回收.
+struct ResourceDeleter {
+    std::pmr::memory_resource* resource = nullptr;
+    void* storage = nullptr;
+    std::size_t size = 0;
+    std::size_t align = 0;
+
+    template <class T>
+    void operator()(T* p) const {
+        p->~T();
+        resource->deallocate(storage, size, align);
+    }
+};
+
+template <class T>
+using ResourcePtr = std::unique_ptr<T, ResourceDeleter>;
+
+// 在 resource 中构造 Concrete, 以 Base 接口返回
+template <class Base, class Concrete, class... Args>
+ResourcePtr<Base> make_in(std::pmr::memory_resource* resource,
+                          Args&&... args) {
+    void* storage = resource->allocate(sizeof(Concrete), alignof(Concrete));
+    Base* p = new (storage) Concrete(std::forward<Args>(args)...);
+    return ResourcePtr<Base>(
+        p, ResourceDeleter{ resource, storage, sizeof(Concrete),
+                            alignof(Concrete) });
+}
+
+// 批量创建的同类型产品, 通过抽象接口按下标访问
+template <class Base>
+class ProductBatch {
+public:
+    virtual std::size_t size() const = 0;
+    virtual const Base& operator[](std::size_t i) const = 0;
+    virtual ~ProductBatch() = default;
+};
+
+// 连续存储的具体产品数组, 按值返回时只有元素数组一次分配.
+// 以具体类型遍历时元素就地存放, 且产品类为 final, 调用可在编译期确定.
+template <class Base, class Concrete>
+class ConcreteProductBatch final : public ProductBatch<Base> {
+private:
+    std::vector<Concrete> items_;
+
+public:
+    using value_type = Concrete;
+
+    explicit ConcreteProductBatch(std::size_t n) : items_(n) {
+    }
+
+    // 元素需要构造参数时, 由 make() 依次生成
+    template <class Make>
+    ConcreteProductBatch(std::size_t n, Make make) {
+        items_.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            items_.push_back(make());
+        }
+    }
+
+    std::size_t size() const override {
+        return items_.size();
+    }
+
+    const Concrete& operator[](std::size_t i) const override {
+        return items_[i];
+    }
+
+    const Concrete* begin() const {
+        return items_.data();
+    }
+
+    const Concrete* end() const {
+        return items_.data() + items_.size();
+    }
+};
+
+// 通过抽象接口返回的批量产品: 对象头与元素放在同一块内存中,
+// 元素紧跟在对象之后, 整个批次只有一次分配
+template <class Base, class Concrete>
+class InlineProductBatch final : public ProductBatch<Base> {
+private:
+    std::size_t size_ = 0;
+
+    // 元素区相对对象起始地址的偏移: 对象大小按元素对齐向上取整
+    static constexpr std::size_t items_offset() {
+        return (sizeof(InlineProductBatch) + alignof(Concrete) - 1) /
+               alignof(Concrete) * alignof(Concrete);
+    }
+
+    Concrete* items() {
+        return reinterpret_cast<Concrete*>(reinterpret_cast<char*>(this) +
+                                           items_offset());
+    }
+
+    const Concrete* items() const {
+        return reinterpret_cast<const Concrete*>(
+            reinterpret_cast<const char*>(this) + items_offset());
+    }
+
+    InlineProductBatch() = default;
+
+public:
+    static_assert(alignof(Concrete) <= alignof(std::max_align_t),
+                  "over-aligned products are not supported");
+
+    // 元素需要构造参数时, 由 make() 依次生成
+    template <class Make>
+    static std::unique_ptr<ProductBatch<Base>> create(std::size_t n,
+                                                      Make make) {
+        std::size_t bytes = items_offset() + n * sizeof(Concrete);
+        void* storage = ::operator new(bytes);
+        auto* batch = new (storage) InlineProductBatch();
+        try {
+            for (; batch->size_ < n; ++batch->size_) {
+                new (batch->items() + batch->size_) Concrete(make());
+            }
+        } catch (...) {
+            delete batch; // 析构已构造的元素并释放整块内存
+            throw;
+        }
+        return std::unique_ptr<ProductBatch<Base>>(batch);
+    }
+
+    static std::unique_ptr<ProductBatch<Base>> create(std::size_t n) {
+        return create(n, []() { return Concrete(); });
+    }
+
+    ~InlineProductBatch() override {
+        for (std::size_t i = size_; i-- > 0;) {
+            items()[i].~Concrete();
+        }
+    }
+
+    // 通过基类指针 delete 时释放 create() 申请的整块内存
+    static void operator delete(void* p) {
+        ::operator delete(p);
+    }
+
+    std::size_t size() const override {
+        return size_;
+    }
+
+    const Concrete& operator[](std::size_t i) const override {
+        return items()[i];
+    }
+
+    const Concrete* begin() const {
+        return items();
+    }
+
+    const Concrete* end() const {
+        return items() + size_;
+    }
+};
+
+// 同一工厂生产的一族产品
+struct ProductFamily {
+    ResourcePtr<AbstractProductA> productA;
+    ResourcePtr<AbstractProductB> productB;
+};
+
 // 抽象工厂
 class AbstractFatory {
 public:
     virtual std::unique_ptr<AbstractProductA> create_productA() const = 0;
     virtual std::unique_ptr<AbstractProductB> create_productB() const = 0;
+
+    // 在调用方提供的内存资源中创建产品
+    virtual ResourcePtr<AbstractProductA>
+    create_productA(std::pmr::memory_resource* resource) const = 0;
+    virtual ResourcePtr<AbstractProductB>
+    create_productB(std::pmr::memory_resource* resource) const = 0;
+
+    // 批量创建: 一次虚调用、一次分配得到 n 个连续存放的产品
+    virtual std::unique_ptr<ProductBatch<AbstractProductA>>
+    create_productsA(std::size_t n) const = 0;
+    virtual std::unique_ptr<ProductBatch<AbstractProductB>>
+    create_productsB(std::size_t n) const = 0;
+
+    ProductFamily create_family(std::pmr::memory_resource* resource) const {
+        return ProductFamily{ create_productA(resource),
+                              create_productB(resource) };
+    }
+
     virtual ~AbstractFatory() = default;
 };
 
+// 请求级 arena: 产品按创建顺序连续存放在预分配的缓冲区中, 请求结束时
+// release() 一次性释放并回到缓冲区起点, 缓冲区在多次请求间复用.
+// 超出缓冲区的部分向全局堆申请, 同样在 release() 时归还.
+class RequestArena {
+private:
+    std::unique_ptr<std::byte[]> buffer_;
+    std::pmr::monotonic_buffer_resource resource_;
+
+public:
+    explicit RequestArena(std::size_t capacity = 64 * 1024) :
+        buffer_(new std::byte[capacity]), resource_(buffer_.get(), capacity) {
+    }
+
+    std::pmr::memory_resource* resource() {
+        return &resource_;
+    }
+
+    // 调用前须先销毁在其中创建的产品
+    void release() {
+        resource_.release();
+    }
+};
+
 // 具体工厂1
 class ConcreteFatory1 : public AbstractFatory {
 public:
@@ -115,6 +346,38 @@ public:
     std::unique_ptr<AbstractProductB> create_productB() const override {
         return std::make_unique<ProdunctB1>();
     }
+
+    ResourcePtr<AbstractProductA>
+    create_productA(std::pmr::memory_resource* resource) const override {
+        return make_in<AbstractProductA, ProdunctA1>(resource);
+    }
+    ResourcePtr<AbstractProductB>
+    create_productB(std::pmr::memory_resource* resource) const override {
+        return make_in<AbstractProductB, ProdunctB1>(resource);
+    }
+
+    std::unique_ptr<ProductBatch<AbstractProductA>>
+    create_productsA(std::size_t n) const override {
+        return InlineProductBatch<AbstractProductA,
+                                  decltype(make_productsA(n))::value_type>::
+            create(n);
+    }
+    std::unique_ptr<ProductBatch<AbstractProductB>>
+    create_productsB(std::size_t n) const override {
+        return InlineProductBatch<AbstractProductB,
+                                  decltype(make_productsB(n))::value_type>::
+            create(n);
+    }
+
+    // 静态类型的批量创建, 工厂类型已知时使用
+    static ConcreteProductBatch<AbstractProductA, ProdunctA1>
+    make_productsA(std::size_t n) {
+        return ConcreteProductBatch<AbstractProductA, ProdunctA1>(n);
+    }
+    static ConcreteProductBatch<AbstractProductB, ProdunctB1>
+    make_productsB(std::size_t n) {
+        return ConcreteProductBatch<AbstractProductB, ProdunctB1>(n);
+    }
 };
 
 // 具体工厂2
@@ -126,7 +389,369 @@ public:
     std::unique_ptr<AbstractProductB> create_productB() const override {
         return std::make_unique<ProdunctB2>();
     }
+
+    ResourcePtr<AbstractProductA>
+    create_productA(std::pmr::memory_resource* resource) const override {
+        return make_in<AbstractProductA, ProdunctA2>(resource);
+    }
+    ResourcePtr<AbstractProductB>
+    create_productB(std::pmr::memory_resource* resource) const override {
+        return make_in<AbstractProductB, ProdunctB2>(resource);
+    }
+
+    std::unique_ptr<ProductBatch<AbstractProductA>>
+    create_productsA(std::size_t n) const override {
+        return InlineProductBatch<AbstractProductA,
+                                  decltype(make_productsA(n))::value_type>::
+            create(n);
+    }
+    std::unique_ptr<ProductBatch<AbstractProductB>>
+    create_productsB(std::size_t n) const override {
+        return InlineProductBatch<AbstractProductB,
+                                  decltype(make_productsB(n))::value_type>::
+            create(n);
+    }
+
+    // 静态类型的批量创建, 工厂类型已知时使用
+    static ConcreteProductBatch<AbstractProductA, ProdunctA2>
+    make_productsA(std::size_t n) {
+        return ConcreteProductBatch<AbstractProductA, ProdunctA2>(n);
+    }
+    static ConcreteProductBatch<AbstractProductB, ProdunctB2>
+    make_productsB(std::size_t n) {
+        return ConcreteProductBatch<AbstractProductB, ProdunctB2>(n);
+    }
+};
+
+#if FACTORY_HAS_PLUGINS
+// 插件提供的产品A, 持有插件创建的不透明句柄
+class PluginProductA final : public AbstractProductA {
+private:
+    const FactoryPluginApi* api_;
+    void* handle_;
+
+public:
+    explicit PluginProductA(const FactoryPluginApi* api) :
+        api_(api), handle_(api->create_productA()) {
+    }
+
+    PluginProductA(PluginProductA&& other) noexcept :
+        api_(other.api_), handle_(other.handle_) {
+        other.handle_ = nullptr;
+    }
+
+    PluginProductA(const PluginProductA&) = delete;
+    PluginProductA& operator=(const PluginProductA&) = delete;
+
+    ~PluginProductA() override {
+        if (handle_) {
+            api_->destroy_productA(handle_);
+        }
+    }
+
+    void methodA() const override {
+        api_->methodA(handle_);
+    }
+};
+
+// 插件提供的产品B
+class PluginProductB final : public AbstractProductB {
+private:
+    const FactoryPluginApi* api_;
+    void* handle_;
+
+public:
+    explicit PluginProductB(const FactoryPluginApi* api) :
+        api_(api), handle_(api->create_productB()) {
+    }
+
+    PluginProductB(PluginProductB&& other) noexcept :
+        api_(other.api_), handle_(other.handle_) {
+        other.handle_ = nullptr;
+    }
+
+    PluginProductB(const PluginProductB&) = delete;
+    PluginProductB& operator=(const PluginProductB&) = delete;
+
+    ~PluginProductB() override {
+        if (handle_) {
+            api_->destroy_productB(handle_);
+        }
+    }
+
+    void methodB() const override {
+        api_->methodB(handle_);
+    }
+};
+
+// 把插件的函数表适配为抽象工厂
+class PluginFactory : public AbstractFatory {
+private:
+    const FactoryPluginApi* api_;
+
+public:
+    explicit PluginFactory(const FactoryPluginApi* api) : api_(api) {
+    }
+
+    std::unique_ptr<AbstractProductA> create_productA() const override {
+        return std::make_unique<PluginProductA>(api_);
+    }
+    std::unique_ptr<AbstractProductB> create_productB() const override {
+        return std::make_unique<PluginProductB>(api_);
+    }
+
+    ResourcePtr<AbstractProductA>
+    create_productA(std::pmr::memory_resource* resource) const override {
+        return make_in<AbstractProductA, PluginProductA>(resource, api_);
+    }
+    ResourcePtr<AbstractProductB>
+    create_productB(std::pmr::memory_resource* resource) const override {
+        return make_in<AbstractProductB, PluginProductB>(resource, api_);
+    }
+
+    std::unique_ptr<ProductBatch<AbstractProductA>>
+    create_productsA(std::size_t n) const override {
+        const FactoryPluginApi* api = api_;
+        return InlineProductBatch<AbstractProductA, PluginProductA>::
+            create(n, [api]() { return PluginProductA(api); });
+    }
+    std::unique_ptr<ProductBatch<AbstractProductB>>
+    create_productsB(std::size_t n) const override {
+        const FactoryPluginApi* api = api_;
+        return InlineProductBatch<AbstractProductB, PluginProductB>::
+            create(n, [api]() { return PluginProductB(api); });
+    }
+};
+
+// 插件注册表: discover() 只扫描目录, 不加载任何库;
+// get() 首次请求某个产品族时才 dlopen, 启动开销只由实际使用的产品族承担.
+// 插件中创建的产品必须在注册表析构(dlclose)之前销毁.
+class FactoryPluginRegistry {
+private:
+    struct Plugin {
+        std::string path;
+        void* library = nullptr;
+        std::unique_ptr<PluginFactory> factory;
+        double load_ms = 0; // 加载耗时, 失败时为失败前花费的时间
+        std::string error;
+
+        explicit Plugin(std::string path) : path(std::move(path)) {
+        }
+    };
+
+    std::map<std::string, Plugin> plugins_;
+    mutable std::mutex mutex_;
+
+    static void load(const std::string& family, Plugin& plugin) {
+        auto start = std::chrono::steady_clock::now();
+        open(family, plugin);
+        auto stop = std::chrono::steady_clock::now();
+        plugin.load_ms =
+            std::chrono::duration<double, std::milli>(stop - start).count();
+    }
+
+    // 函数表中的指针都由插件提供, 任何一个为空都拒绝加载
+    static bool complete(const FactoryPluginApi& api) {
+        return api.create_productA && api.methodA && api.destroy_productA &&
+               api.create_productB && api.methodB && api.destroy_productB;
+    }
+
+    static void open(const std::string& family, Plugin& plugin) {
+        plugin.library = dlopen(plugin.path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!plugin.library) {
+            const char* message = dlerror();
+            plugin.error = message ? message : "dlopen failed";
+            return;
+        }
+        auto entry = reinterpret_cast<FactoryPluginEntry>(
+            dlsym(plugin.library, FACTORY_PLUGIN_ENTRY));
+        const FactoryPluginApi* api = entry ? entry() : nullptr;
+        if (!api) {
+            plugin.error = "missing entry point " FACTORY_PLUGIN_ENTRY;
+        } else if (api->abi_version != FACTORY_PLUGIN_ABI_VERSION) {
+            plugin.error = "abi version mismatch";
+        } else if (!api->family) {
+            plugin.error = "missing family name";
+        } else if (family != api->family) {
+            plugin.error = "family name mismatch";
+        } else if (!complete(*api)) {
+            plugin.error = "missing product function";
+        } else {
+            plugin.factory = std::make_unique<PluginFactory>(api);
+        }
+        if (!plugin.factory) {
+            dlclose(plugin.library);
+            plugin.library = nullptr;
+        }
+    }
+
+public:
+    FactoryPluginRegistry() = default;
+    FactoryPluginRegistry(const FactoryPluginRegistry&) = delete;
+    FactoryPluginRegistry& operator=(const FactoryPluginRegistry&) = delete;
+
+    ~FactoryPluginRegistry() {
+        for (auto& entry: plugins_) {
+            entry.second.factory.reset();
+            if (entry.second.library) {
+                dlclose(entry.second.library);
+            }
+        }
+    }
+
+    // 登记目录中的 lib<产品族名>.so, 返回新发现的插件数量
+    std::size_t discover(const std::string& directory) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        std::size_t found = 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const fs::directory_entry& entry:
+             fs::directory_iterator(directory, ec)) {
+            std::string name = entry.path().filename().string();
+            if (entry.path().extension() != ".so" || name.rfind("lib", 0)) {
+                continue;
+            }
+            std::string family = entry.path().stem().string().substr(3);
+            if (plugins_.emplace(family, Plugin(entry.path().string()))
+                    .second) {
+                ++found;
+            }
+        }
+        return found;
+    }
+
+    // 获取产品族的工厂, 未发现或加载失败时返回 nullptr
+    const AbstractFatory* get(const std::string& family) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = plugins_.find(family);
+        if (it == plugins_.end()) {
+            return nullptr;
+        }
+        Plugin& plugin = it->second;
+        if (!plugin.factory && plugin.error.empty()) {
+            load(family, plugin);
+        }
+        return plugin.factory.get();
+    }
+
+    // 输出每个插件的状态与加载耗时
+    void report(std::ostream& os) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry: plugins_) {
+            const Plugin& plugin = entry.second;
+            os << entry.first << ": ";
+            if (plugin.factory) {
+                os << "loaded in " << plugin.load_ms << " ms";
+            } else if (!plugin.error.empty()) {
+                os << "failed after " << plugin.load_ms << " ms ("
+                   << plugin.error << ")";
+            } else {
+                os << "not loaded";
+            }
+            os << std::endl;
+        }
+    }
 };
+#endif
+
+// 每个请求创建 n 族产品: 逐个 make_unique 与请求级 arena 的对比.
+// 平均每个产品占用的地址跨度反映同一请求的产品是否紧凑连续存放,
+// 跨度越小, 遍历时触及的缓存行越少.
+void arena_benchmark(const AbstractFatory& factory, std::size_t requests,
+                     std::size_t n) {
+    double heap_ns = 0;
+    double arena_ns = 0;
+    std::size_t heap_span = 0;
+    std::size_t arena_span = 0;
+    RequestArena arena(2 * n * 16);
+
+    for (std::size_t r = 0; r < requests; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::unique_ptr<AbstractProductA>> as;
+            std::vector<std::unique_ptr<AbstractProductB>> bs;
+            as.reserve(n);
+            bs.reserve(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                as.push_back(factory.create_productA());
+                bs.push_back(factory.create_productB());
+            }
+            std::uintptr_t lo = UINTPTR_MAX, hi = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::uintptr_t p:
+                     { reinterpret_cast<std::uintptr_t>(as[i].get()),
+                       reinterpret_cast<std::uintptr_t>(bs[i].get()) }) {
+                    lo = std::min(lo, p);
+                    hi = std::max(hi, p);
+                }
+            }
+            heap_span += hi - lo;
+        }
+        auto stop = std::chrono::steady_clock::now();
+        heap_ns += std::chrono::duration<double, std::nano>(stop - start)
+                       .count();
+
+        start = std::chrono::steady_clock::now();
+        {
+            std::vector<ProductFamily> families;
+            families.reserve(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                families.push_back(factory.create_family(arena.resource()));
+            }
+            std::uintptr_t lo = UINTPTR_MAX, hi = 0;
+            for (const ProductFamily& f: families) {
+                for (std::uintptr_t p:
+                     { reinterpret_cast<std::uintptr_t>(f.productA.get()),
+                       reinterpret_cast<std::uintptr_t>(f.productB.get()) }) {
+                    lo = std::min(lo, p);
+                    hi = std::max(hi, p);
+                }
+            }
+            arena_span += hi - lo;
+        }
+        arena.release();
+        stop = std::chrono::steady_clock::now();
+        arena_ns += std::chrono::duration<double, std::nano>(stop - start)
+                        .count();
+    }
+
+    std::cout << "heap:  " << heap_ns / (requests * n) << " ns/family, "
+              << heap_span / (requests * 2 * n) << " bytes/product"
+              << std::endl;
+    std::cout << "arena: " << arena_ns / (requests * n) << " ns/family, "
+              << arena_span / (requests * 2 * n) << " bytes/product"
+              << std::endl;
+}
+
+// 创建 n 个产品A: 逐个 create_productA 与批量创建的对比
+void bulk_benchmark(const AbstractFatory& factory, std::size_t n) {
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::unique_ptr<AbstractProductA>> products;
+        products.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            products.push_back(factory.create_productA());
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    std::cout << "one by one: "
+              << std::chrono::duration<double, std::nano>(stop - start)
+                         .count() /
+                     n
+              << " ns/product" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    {
+        std::unique_ptr<ProductBatch<AbstractProductA>> products =
+            factory.create_productsA(n);
+    }
+    stop = std::chrono::steady_clock::now();
+    std::cout << "bulk:       "
+              << std::chrono::duration<double, std::nano>(stop - start)
+                         .count() /
+                     n
+              << " ns/product" << std::endl;
+}
 
 int main(int argc, char* argv[]) {
     // 具体工厂1
@@ -148,5 +773,42 @@ int main(int argc, char* argv[]) {
     std::unique_ptr<AbstractProductB> productB2 = factory2->create_productB();
     productB2->methodB();
 
+    // 一次请求的整族产品放在 arena 中
+    RequestArena arena;
+    {
+        ProductFamily family = factory1->create_family(arena.resource());
+        family.productA->methodA();
+        family.productB->methodB();
+    }
+    arena.release();
+
+    arena_benchmark(*factory2, 100, 10000);
+
+    // 批量创建: 抽象接口按下标访问
+    std::unique_ptr<ProductBatch<AbstractProductB>> batch =
+        factory1->create_productsB(2);
+    for (std::size_t i = 0; i < batch->size(); ++i) {
+        (*batch)[i].methodB();
+    }
+
+    // 批量创建: 具体类型直接遍历
+    for (const ProdunctA2& product: ConcreteFatory2::make_productsA(2)) {
+        product.methodA();
+    }
+
+    bulk_benchmark(*factory1, 100000);
+
+#if FACTORY_HAS_PLUGINS
+    // 插件产品族: 目录默认为 ./plugins, 只加载用到的产品族
+    FactoryPluginRegistry registry;
+    std::size_t found = registry.discover(argc > 1 ? argv[1] : "plugins");
+    std::cout << "discovered " << found << " plugin(s)" << std::endl;
+    if (const AbstractFatory* factory3 = registry.get("family3")) {
+        factory3->create_productA()->methodA();
+        factory3->create_productsB(1)->operator[](0).methodB();
+    }
+    registry.report(std::cout);
+#endif
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+/**
+ * @file family_plugin.cpp
+ * @author wenshuyu (wsy2161826815@163.com)
+ * @brief 以插件形式提供的产品族
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <iostream>
+
+#include "../factory_plugin.h"
+
+/**
+ * 产品族插件示例, PLUGIN_FAMILY 决定产品族编号.
+ * 在本目录执行 make, 生成 ../plugins/libfamily3.so 与 ../plugins/libfamily4.so.
+ */
+
+#ifndef PLUGIN_FAMILY
+#define PLUGIN_FAMILY 3
+#endif
+
+#define PLUGIN_STR_(x) #x
+#define PLUGIN_STR(x) PLUGIN_STR_(x)
+
+namespace {
+
+// 产品A
+struct ProdunctA {
+    const char* name = "ProdunctA" PLUGIN_STR(PLUGIN_FAMILY);
+};
+
+// 产品B
+struct ProdunctB {
+    const char* name = "ProdunctB" PLUGIN_STR(PLUGIN_FAMILY);
+};
+
+}
+
+// 回调与 FactoryPluginApi 中的函数指针一样具有 C 语言链接
+extern "C" {
+
+static void* create_productA(void) {
+    return new ProdunctA();
+}
+
+static void methodA(const void* product) {
+    std::cout << static_cast<const ProdunctA*>(product)->name
+              << "::methodA()" << std::endl;
+}
+
+static void destroy_productA(void* product) {
+    delete static_cast<ProdunctA*>(product);
+}
+
+static void* create_productB(void) {
+    return new ProdunctB();
+}
+
+static void methodB(const void* product) {
+    std::cout << static_cast<const ProdunctB*>(product)->name
+              << "::methodB()" << std::endl;
+}
+
+static void destroy_productB(void* product) {
+    delete static_cast<ProdunctB*>(product);
+}
+
+static const FactoryPluginApi kApi = {
+    FACTORY_PLUGIN_ABI_VERSION,
+    "family" PLUGIN_STR(PLUGIN_FAMILY),
+    create_productA,
+    methodA,
+    destroy_productA,
+    create_productB,
+    methodB,
+    destroy_productB,
+};
+
+__attribute__((visibility("default"))) const FactoryPluginApi*
+factory_plugin_entry_v1(void) {
+    return &kApi;
+}
+} // extern "C"
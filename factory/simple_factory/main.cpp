@@ -27,7 +27,32 @@
  *
  */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BATCH_HAS_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define BATCH_HAS_X86_SIMD 0
+#endif
 
 /**
  * 简单工厂模式的用途：
@@ -46,11 +71,48 @@
  * - `Operation`是抽象基类, 定义了基本操作的接口. 
  * - `OperationAdd`、`OperationSub`、`OperationMul`和`OperationDiv`是具体实现类, 分别表示加、减、乘、除操作. 
  * - `OperationFactory`是简单工厂类, 根据传入的运算符`op`创建对应的操作对象. 
+ *   各操作类定义后用`REGISTER_OPERATION`注册运算符, 工厂在编译期生成以运算符为下标的查找表,
+ *   运算符在编译期已知时可用`MakeOperation<'+'>()`静态分发. 
  * 客户端代码通过工厂创建操作对象并设置操作数, 而无需直接实例化具体的操作类. 
+ * - `OperationFactory::CreateBatchKernel`根据运算符返回批量计算内核`BatchKernel`,
+ *   一次处理整段操作数数组, 运行时按 CPU 能力选择 AVX-512/AVX2/标量实现. 
+ * - `OperationFactory::MakeOperation`返回拥有所有权的`OperationPtr`,
+ *   对象来自按类型划分的空闲链表池`OperationPool`, 稳态下创建不再调用 malloc. 
+ * - `operand`/`BinaryExpr`把多个运算组合成表达式模板, `evaluate`一次遍历
+ *   输入数组得到结果, 不产生中间对象和临时数组. 
+ * - `OperationFactory::CreateReducer`/`CreateScanner`返回并行归约/扫描内核,
+ *   按缓存大小分块分配给多个线程, 加法使用 Kahan 补偿与两两合并保证精度, 
+ *   除法的除数乘积分开保存尾数与指数, 不会比左折叠先溢出. 
  * 这种设计使得代码更加清晰、易于扩展和维护. 
  */
 
 
+// 统计全局堆分配次数, 用于对比对象池与 new/delete
+static std::atomic<std::size_t> g_heap_allocs{ 0 };
+
+// 替换的 new/delete 保持为独立函数, 内联后 GCC 会误报 -Wmismatched-new-delete
+#if defined(__GNUC__) || defined(__clang__)
+#define ALLOC_COUNT_NOINLINE __attribute__((noinline))
+#else
+#define ALLOC_COUNT_NOINLINE
+#endif
+
+ALLOC_COUNT_NOINLINE void* operator new(std::size_t size) {
+    g_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+ALLOC_COUNT_NOINLINE void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+ALLOC_COUNT_NOINLINE void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
 // 操作基类
 class Operation {
 public:
@@ -62,84 +124,1286 @@ public:
     virtual ~Operation() = default;
 };
 
+// 操作注册: 每个操作类定义之后用 REGISTER_OPERATION 声明自己的运算符,
+// 即特化 operation_for<symbol>. 工厂在编译期遍历全部运算符生成查找表,
+// 新增运算不需要修改任何集中列表; 运算符重复注册是重复特化, 编译失败.
+// 注册需出现在查找表(kOperationTable)之前.
+template <char op>
+struct operation_for {
+    using type = void;
+};
+
+#define REGISTER_OPERATION(T)          \
+    template <>                        \
+    struct operation_for<T::symbol> { \
+        using type = T;                \
+    }
+
+// 编译期按运算符查找操作类型, 未注册时为 void
+template <char op>
+using OperationOf = typename operation_for<op>::type;
+
 // 加法类
 class OperationAdd : public Operation {
 public:
+    static constexpr char symbol = '+';
+
+    static double apply(double a, double b) {
+        return a + b;
+    }
+
+#if BATCH_HAS_X86_SIMD
+    // 向量版本: 逐通道与标量 apply 结果相同
+    __attribute__((target("avx2"))) static __m256d apply(__m256d a,
+                                                         __m256d b) {
+        return _mm256_add_pd(a, b);
+    }
+
+    __attribute__((target("avx512f"))) static __m512d apply(__m512d a,
+                                                            __m512d b) {
+        return _mm512_add_pd(a, b);
+    }
+#endif
+
     double get_result() const override {
-        return number_1 + number_2;
+        return apply(number_1, number_2);
     }
 };
 
+REGISTER_OPERATION(OperationAdd);
+
 // 减法类
 class OperationSub : public Operation {
 public:
+    static constexpr char symbol = '-';
+
+    static double apply(double a, double b) {
+        return a - b;
+    }
+
+#if BATCH_HAS_X86_SIMD
+    // 向量版本: 逐通道与标量 apply 结果相同
+    __attribute__((target("avx2"))) static __m256d apply(__m256d a,
+                                                         __m256d b) {
+        return _mm256_sub_pd(a, b);
+    }
+
+    __attribute__((target("avx512f"))) static __m512d apply(__m512d a,
+                                                            __m512d b) {
+        return _mm512_sub_pd(a, b);
+    }
+#endif
+
     double get_result() const override {
-        return number_1 - number_2;
+        return apply(number_1, number_2);
     }
 };
 
+REGISTER_OPERATION(OperationSub);
+
 // 乘法类
 class OperationMul : public Operation {
 public:
+    static constexpr char symbol = '*';
+
+    static double apply(double a, double b) {
+        return a * b;
+    }
+
+#if BATCH_HAS_X86_SIMD
+    // 向量版本: 逐通道与标量 apply 结果相同
+    __attribute__((target("avx2"))) static __m256d apply(__m256d a,
+                                                         __m256d b) {
+        return _mm256_mul_pd(a, b);
+    }
+
+    __attribute__((target("avx512f"))) static __m512d apply(__m512d a,
+                                                            __m512d b) {
+        return _mm512_mul_pd(a, b);
+    }
+#endif
+
     double get_result() const override {
-        return number_1 * number_2;
+        return apply(number_1, number_2);
     }
 };
 
+REGISTER_OPERATION(OperationMul);
+
 // 除法类
 class OperationDiv : public Operation {
 public:
+    static constexpr char symbol = '/';
+
+    static double apply(double a, double b) {
+        return a / b;
+    }
+
+#if BATCH_HAS_X86_SIMD
+    // 向量版本: 逐通道与标量 apply 结果相同
+    __attribute__((target("avx2"))) static __m256d apply(__m256d a,
+                                                         __m256d b) {
+        return _mm256_div_pd(a, b);
+    }
+
+    __attribute__((target("avx512f"))) static __m512d apply(__m512d a,
+                                                            __m512d b) {
+        return _mm512_div_pd(a, b);
+    }
+#endif
+
     double get_result() const override {
-        return number_1 / number_2;
+        return apply(number_1, number_2);
+    }
+};
+
+REGISTER_OPERATION(OperationDiv);
+
+// 对象池: 每种操作类型一个池, 槽位按块申请并串成空闲链表.
+// 每个线程持有自己的空闲链表, 创建和回收都不加锁; 只有本地链表为空时
+// 才加锁从全局链表取回一批槽位或申请新块. 本地链表超过上限时(例如总在
+// 另一个线程回收)把一批槽位归还全局, 线程退出时归还全部槽位.
+// trim() 释放所有槽位都在全局链表中的块.
+template <class T>
+class OperationPool {
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static constexpr std::size_t kChunkSlots = 64;
+    static constexpr std::size_t kLocalLimit = 2 * kChunkSlots;
+
+    struct Shared {
+        std::mutex mutex;
+        Slot* free_list = nullptr;
+        std::size_t free_count = 0;
+        std::vector<std::unique_ptr<Slot[]>> chunks;
+    };
+
+    struct Local {
+        Slot* free_list = nullptr;
+        std::size_t count = 0;
+
+        ~Local() {
+            give_back(*this, count);
+        }
+    };
+
+    static Shared& shared() {
+        static Shared s;
+        return s;
+    }
+
+    static Local& local() {
+        thread_local Local l;
+        return l;
+    }
+
+    // 把本地链表头部的 n 个槽位归还全局链表
+    static void give_back(Local& l, std::size_t n) {
+        if (n == 0) {
+            return;
+        }
+        Slot* head = l.free_list;
+        Slot* tail = head;
+        for (std::size_t i = 1; i < n; ++i) {
+            tail = tail->next;
+        }
+        l.free_list = tail->next;
+        l.count -= n;
+        Shared& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        tail->next = s.free_list;
+        s.free_list = head;
+        s.free_count += n;
+    }
+
+    // 从全局链表取回至多一块的槽位, 全局链表为空时申请新块
+    static void refill(Local& l) {
+        Shared& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.free_list) {
+            Slot* head = s.free_list;
+            Slot* tail = head;
+            std::size_t n = 1;
+            while (n < kChunkSlots && tail->next) {
+                tail = tail->next;
+                ++n;
+            }
+            s.free_list = tail->next;
+            s.free_count -= n;
+            tail->next = nullptr;
+            l.free_list = head;
+            l.count = n;
+            return;
+        }
+        std::unique_ptr<Slot[]> chunk(new Slot[kChunkSlots]);
+        for (std::size_t i = 0; i + 1 < kChunkSlots; ++i) {
+            chunk[i].next = &chunk[i + 1];
+        }
+        chunk[kChunkSlots - 1].next = nullptr;
+        l.free_list = chunk.get();
+        l.count = kChunkSlots;
+        s.chunks.push_back(std::move(chunk));
+    }
+
+public:
+    static T* create() {
+        Local& l = local();
+        if (!l.free_list) {
+            refill(l);
+        }
+        Slot* slot = l.free_list;
+        l.free_list = slot->next;
+        --l.count;
+        return new (slot->storage) T();
+    }
+
+    static void destroy(Operation* operation) {
+        T* object = static_cast<T*>(operation);
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        Local& l = local();
+        slot->next = l.free_list;
+        l.free_list = slot;
+        if (++l.count > kLocalLimit) {
+            give_back(l, kChunkSlots);
+        }
+    }
+
+    // 释放所有槽位都已归还全局链表的块, 返回释放的块数.
+    // 仍在各线程本地链表中的槽位不参与回收
+    static std::size_t trim() {
+        Shared& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        std::sort(s.chunks.begin(), s.chunks.end(),
+                  [](const std::unique_ptr<Slot[]>& a,
+                     const std::unique_ptr<Slot[]>& b) {
+                      return std::less<Slot*>()(a.get(), b.get());
+                  });
+        // 按地址找到每个空闲槽位所属的块并计数
+        auto chunk_of = [&s](Slot* slot) {
+            auto it = std::upper_bound(
+                s.chunks.begin(), s.chunks.end(), slot,
+                [](Slot* p, const std::unique_ptr<Slot[]>& c) {
+                    return std::less<Slot*>()(p, c.get());
+                });
+            return static_cast<std::size_t>(it - s.chunks.begin()) - 1;
+        };
+        std::vector<std::size_t> free_slots(s.chunks.size(), 0);
+        for (Slot* slot = s.free_list; slot; slot = slot->next) {
+            ++free_slots[chunk_of(slot)];
+        }
+
+        // 从全局链表中摘除完全空闲的块的槽位
+        Slot** link = &s.free_list;
+        while (*link) {
+            if (free_slots[chunk_of(*link)] == kChunkSlots) {
+                *link = (*link)->next;
+                --s.free_count;
+            } else {
+                link = &(*link)->next;
+            }
+        }
+        std::size_t released = 0;
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < s.chunks.size(); ++i) {
+            if (free_slots[i] == kChunkSlots) {
+                ++released;
+            } else {
+                s.chunks[kept++] = std::move(s.chunks[i]);
+            }
+        }
+        s.chunks.resize(kept);
+        return released;
+    }
+
+    // 当前持有的块数
+    static std::size_t chunk_count() {
+        Shared& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.chunks.size();
+    }
+};
+
+// 把对象归还给创建它的类型池
+struct OperationDeleter {
+    void (*recycle)(Operation*) = nullptr;
+
+    void operator()(Operation* operation) const {
+        recycle(operation);
+    }
+};
+
+// 拥有所有权的操作句柄, 离开作用域时自动回收到对象池
+using OperationPtr = std::unique_ptr<Operation, OperationDeleter>;
+
+template <class T>
+OperationPtr make_pooled_operation() {
+    return OperationPtr(OperationPool<T>::create(),
+                        OperationDeleter{ &OperationPool<T>::destroy });
+}
+
+// 批量计算内核: out[i] = a[i] op b[i], i ∈ [0, n)
+using BatchKernel = void (*)(const double* a, const double* b, double* out,
+                             std::size_t n);
+
+// 批量内核的指令集
+enum class BatchIsa
+{
+    Best,   // 运行时选择当前 CPU 支持的最优实现
+    Scalar, // 标量回退实现
+    Avx2,
+    Avx512,
+};
+
+// 单个元素的标量运算, 与对应 Operation::get_result() 完全一致
+template <char op>
+inline double batch_apply(double a, double b) {
+    return OperationOf<op>::apply(a, b);
+}
+
+template <char op>
+void batch_scalar_kernel(const double* a, const double* b, double* out,
+                         std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = batch_apply<op>(a[i], b[i]);
+    }
+}
+
+#if BATCH_HAS_X86_SIMD
+// 向量内核调用操作类的向量 apply. 加减乘除在 IEEE 754 下都是正确舍入的
+// 单次运算, 逐通道结果与标量路径逐位相同(不使用 FMA, 不改变运算顺序).
+template <char op>
+__attribute__((target("avx2"))) void
+batch_avx2_kernel(const double* a, const double* b, double* out,
+                  std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(a + i);
+        __m256d y = _mm256_loadu_pd(b + i);
+        _mm256_storeu_pd(out + i, OperationOf<op>::apply(x, y));
+    }
+    for (; i < n; ++i) {
+        out[i] = batch_apply<op>(a[i], b[i]);
+    }
+}
+
+template <char op>
+__attribute__((target("avx512f"))) void
+batch_avx512_kernel(const double* a, const double* b, double* out,
+                    std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d x = _mm512_loadu_pd(a + i);
+        __m512d y = _mm512_loadu_pd(b + i);
+        _mm512_storeu_pd(out + i, OperationOf<op>::apply(x, y));
+    }
+    for (; i < n; ++i) {
+        out[i] = batch_apply<op>(a[i], b[i]);
+    }
+}
+#endif
+
+#if BATCH_HAS_X86_SIMD
+// 操作类是否提供了对应宽度的向量 apply, 由此决定可用的向量内核
+template <class T>
+constexpr auto has_avx2_apply(int)
+    -> decltype(T::apply(__m256d{}, __m256d{}), true) {
+    return true;
+}
+
+template <class T>
+constexpr bool has_avx2_apply(...) {
+    return false;
+}
+
+template <class T>
+constexpr auto has_avx512_apply(int)
+    -> decltype(T::apply(__m512d{}, __m512d{}), true) {
+    return true;
+}
+
+template <class T>
+constexpr bool has_avx512_apply(...) {
+    return false;
+}
+#endif
+
+// 按指令集选择内核, 当前 CPU 不支持时返回 nullptr
+template <char op>
+BatchKernel select_batch_kernel(BatchIsa isa) {
+#if BATCH_HAS_X86_SIMD
+    using T = OperationOf<op>;
+    constexpr bool vec512 = has_avx512_apply<T>(0);
+    constexpr bool vec256 = has_avx2_apply<T>(0);
+    bool has_avx512 = vec512 && __builtin_cpu_supports("avx512f");
+    bool has_avx2 = vec256 && __builtin_cpu_supports("avx2");
+    BatchKernel avx512 = nullptr;
+    BatchKernel avx2 = nullptr;
+    if constexpr (vec512) {
+        avx512 = batch_avx512_kernel<op>;
+    }
+    if constexpr (vec256) {
+        avx2 = batch_avx2_kernel<op>;
+    }
+    switch (isa) {
+        case BatchIsa::Best:
+            if (has_avx512) {
+                return avx512;
+            }
+            if (has_avx2) {
+                return avx2;
+            }
+            return batch_scalar_kernel<op>;
+        case BatchIsa::Avx512:
+            return has_avx512 ? avx512 : nullptr;
+        case BatchIsa::Avx2:
+            return has_avx2 ? avx2 : nullptr;
+        case BatchIsa::Scalar:
+            return batch_scalar_kernel<op>;
+    }
+    return nullptr;
+#endif
+    if (isa == BatchIsa::Best || isa == BatchIsa::Scalar) {
+        return batch_scalar_kernel<op>;
+    }
+    return nullptr;
+}
+
+// 并行归约: 左折叠 data[0] op data[1] op ... op data[n-1], threads 为 0 时
+// 使用全部硬件线程
+using ReduceKernel = double (*)(const double* data, std::size_t n,
+                                unsigned threads);
+
+// 并行扫描: out[i] = data[0] op ... op data[i]
+using ScanKernel = void (*)(const double* data, double* out, std::size_t n,
+                            unsigned threads);
+
+// 每个分块 4096 个 double(32 KiB), 正好放入 L1 数据缓存.
+// 分块边界与线程数无关, 因此任意线程数下结果都完全一致.
+constexpr std::size_t kReduceChunk = 4096;
+
+// 折叠时使用的可结合运算: a - b - c = a - (b + c).
+// 除法另行处理, 见 ScaledProduct
+template <class T>
+struct fold_combiner {
+    using type = T;
+};
+
+template <>
+struct fold_combiner<OperationSub> {
+    using type = OperationAdd;
+};
+
+// 除法折叠为 a / (b * c * ...) 时, 除数的乘积远比左折叠的中间结果更早
+// 上溢或下溢. 乘积的尾数与二进制指数分开保存, 每次相乘后用 frexp 归一化;
+// 乘以 2 的幂是精确的, 因此在不溢出的范围内结果与直接相乘完全一致.
+// 0、inf 与 nan 不做归一化, 直接保留在尾数中
+struct ScaledProduct {
+    double mantissa = 1; // 0.5 <= |mantissa| < 1, 或为 0、inf、nan
+    long exponent = 0;
+
+    void multiply(double m, long e) {
+        double product = mantissa * m;
+        if (product == 0 || !std::isfinite(product)) {
+            mantissa = product;
+            return;
+        }
+        int scale;
+        mantissa = std::frexp(product, &scale);
+        exponent += e + scale;
+    }
+
+    void multiply(double x) {
+        if (x == 0 || !std::isfinite(x)) {
+            mantissa *= x;
+            return;
+        }
+        int e;
+        double m = std::frexp(x, &e);
+        multiply(m, e);
+    }
+
+    void multiply(const ScaledProduct& other) {
+        multiply(other.mantissa, other.exponent);
+    }
+
+    // dividend / 乘积, 只在最后一步舍入到 double 的指数范围
+    double divide(double dividend) const {
+        if (dividend == 0 || !std::isfinite(dividend) || mantissa == 0 ||
+            !std::isfinite(mantissa)) {
+            return dividend / mantissa;
+        }
+        int e;
+        double m = std::frexp(dividend, &e);
+        long scale = std::clamp<long>(e - exponent, -4096, 4096);
+        return std::ldexp(m / mantissa, static_cast<int>(scale));
+    }
+};
+
+// 常驻的分块工作线程: 线程按需创建后在条件变量上等待任务, 归约和扫描
+// 不再为每次调用创建和回收线程. 同一时刻只执行一个任务, 并发调用排队;
+// 任务内部不能再调用 parallel_for_chunks.
+class ChunkWorkers {
+private:
+    std::mutex run_mutex; // 串行化任务
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::vector<std::thread> threads;
+    void (*invoke)(void*) = nullptr;
+    void* context = nullptr;
+    std::uint64_t generation = 0;
+    unsigned wanted = 0; // 本次任务使用的工作线程数(不含调用线程)
+    unsigned active = 0; // 尚未完成本次任务的工作线程数
+    bool stopping = false;
+
+    void loop(unsigned index) {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] {
+                return stopping || (generation != seen && index < wanted);
+            });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            void (*task)(void*) = invoke;
+            void* ctx = context;
+            lock.unlock();
+            task(ctx);
+            lock.lock();
+            if (--active == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+public:
+    ChunkWorkers() = default;
+    ChunkWorkers(const ChunkWorkers&) = delete;
+    ChunkWorkers& operator=(const ChunkWorkers&) = delete;
+
+    ~ChunkWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t: threads) {
+            t.join();
+        }
+    }
+
+    static ChunkWorkers& instance() {
+        static ChunkWorkers workers;
+        return workers;
+    }
+
+    // 在调用线程和 helpers 个工作线程上各执行一次 task(ctx), 全部完成后返回
+    void run(unsigned helpers, void (*task)(void*), void* ctx) {
+        std::lock_guard<std::mutex> run_lock(run_mutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (threads.size() < helpers) {
+                unsigned index = static_cast<unsigned>(threads.size());
+                threads.emplace_back([this, index] { loop(index); });
+            }
+            invoke = task;
+            context = ctx;
+            wanted = helpers;
+            active = helpers;
+            ++generation;
+        }
+        wake.notify_all();
+        task(ctx);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return active == 0; });
+    }
+};
+
+// 把 [0, chunks) 的分块动态分配给 threads 个线程执行
+template <class F>
+void parallel_for_chunks(std::size_t chunks, unsigned threads, F fn) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(
+        std::min<std::size_t>(threads, std::max<std::size_t>(chunks, 1)));
+    std::atomic<std::size_t> next{ 0 };
+    auto worker = [&]() {
+        for (std::size_t c = next.fetch_add(1); c < chunks;
+             c = next.fetch_add(1)) {
+            fn(c);
+        }
+    };
+    if (threads == 1) {
+        worker();
+        return;
+    }
+    ChunkWorkers::instance().run(
+        threads - 1,
+        [](void* ctx) { (*static_cast<decltype(worker)*>(ctx))(); },
+        &worker);
+}
+
+// 分块内折叠, 加法使用 Kahan 补偿求和
+template <class C>
+double chunk_fold(const double* data, std::size_t n) {
+    double r = data[0];
+    if constexpr (std::is_same<C, OperationAdd>::value) {
+        double c = 0;
+        for (std::size_t i = 1; i < n; ++i) {
+            double y = data[i] - c;
+            double t = r + y;
+            c = (t - r) - y;
+            r = t;
+        }
+    } else {
+        for (std::size_t i = 1; i < n; ++i) {
+            r = C::apply(r, data[i]);
+        }
+    }
+    return r;
+}
+
+// 分块结果两两合并, 误差增长为 O(log n)
+template <class C>
+double pairwise_fold(const double* data, std::size_t n) {
+    if (n == 1) {
+        return data[0];
+    }
+    std::size_t half = n / 2;
+    return C::apply(pairwise_fold<C>(data, half),
+                    pairwise_fold<C>(data + half, n - half));
+}
+
+template <class C>
+double combine_reduce(const double* data, std::size_t n, unsigned threads) {
+    std::size_t chunks = (n + kReduceChunk - 1) / kReduceChunk;
+    std::vector<double> partials(chunks);
+    parallel_for_chunks(chunks, threads, [&](std::size_t c) {
+        std::size_t begin = c * kReduceChunk;
+        std::size_t len = std::min(kReduceChunk, n - begin);
+        partials[c] = chunk_fold<C>(data + begin, len);
+    });
+    return pairwise_fold<C>(partials.data(), chunks);
+}
+
+// 各分块的除数乘积, 分块边界与 combine_reduce 相同
+inline std::vector<ScaledProduct>
+divisor_products(const double* divisors, std::size_t n, unsigned threads) {
+    std::size_t chunks = (n + kReduceChunk - 1) / kReduceChunk;
+    std::vector<ScaledProduct> products(chunks);
+    parallel_for_chunks(chunks, threads, [&](std::size_t c) {
+        std::size_t begin = c * kReduceChunk;
+        std::size_t end = std::min(begin + kReduceChunk, n);
+        ScaledProduct p;
+        for (std::size_t i = begin; i < end; ++i) {
+            p.multiply(divisors[i]);
+        }
+        products[c] = p;
+    });
+    return products;
+}
+
+// a / b / c / ... = a / (b * c * ...), 要求 n >= 2
+inline double divide_reduce(const double* data, std::size_t n,
+                            unsigned threads) {
+    ScaledProduct total;
+    for (const ScaledProduct& p: divisor_products(data + 1, n - 1, threads)) {
+        total.multiply(p);
+    }
+    return total.divide(data[0]);
+}
+
+template <class T>
+double parallel_reduce(const double* data, std::size_t n, unsigned threads) {
+    using C = typename fold_combiner<T>::type;
+    if (n == 0) {
+        return std::is_same<T, OperationMul>::value ||
+                       std::is_same<T, OperationDiv>::value
+                   ? 1.0
+                   : 0.0;
+    }
+    if constexpr (std::is_same<T, OperationDiv>::value) {
+        return n == 1 ? data[0] : divide_reduce(data, n, threads);
+    }
+    if (std::is_same<C, T>::value) {
+        return combine_reduce<C>(data, n, threads);
+    }
+    if (n == 1) {
+        return data[0];
+    }
+    return T::apply(data[0], combine_reduce<C>(data + 1, n - 1, threads));
+}
+
+// 三阶段扫描: 分块求总和 -> 串行求分块前缀 -> 各分块带偏移扫描.
+// 加法在每个分块内与分块前缀上都使用 Kahan 补偿.
+template <class C>
+void combine_scan(const double* data, double* out, std::size_t n,
+                  unsigned threads) {
+    std::size_t chunks = (n + kReduceChunk - 1) / kReduceChunk;
+    std::vector<double> totals(chunks);
+    parallel_for_chunks(chunks, threads, [&](std::size_t c) {
+        std::size_t begin = c * kReduceChunk;
+        std::size_t len = std::min(kReduceChunk, n - begin);
+        totals[c] = chunk_fold<C>(data + begin, len);
+    });
+
+    // offsets[c] 为分块 c 之前所有元素的折叠结果, 补偿项随之传递
+    std::vector<double> offsets(chunks), compensations(chunks);
+    double acc = 0, comp = 0;
+    for (std::size_t c = 0; c < chunks; ++c) {
+        offsets[c] = acc;
+        compensations[c] = comp;
+        if (c == 0) {
+            acc = totals[0];
+        } else if (std::is_same<C, OperationAdd>::value) {
+            double y = totals[c] - comp;
+            double t = acc + y;
+            comp = (t - acc) - y;
+            acc = t;
+        } else {
+            acc = C::apply(acc, totals[c]);
+        }
     }
+
+    parallel_for_chunks(chunks, threads, [&](std::size_t c) {
+        std::size_t begin = c * kReduceChunk;
+        std::size_t end = std::min(begin + kReduceChunk, n);
+        double r = c == 0 ? data[0] : C::apply(offsets[c], data[begin]);
+        double comp = 0;
+        if (std::is_same<C, OperationAdd>::value && c > 0) {
+            double y = data[begin] - compensations[c];
+            r = offsets[c] + y;
+            comp = (r - offsets[c]) - y;
+        }
+        out[begin] = r;
+        for (std::size_t i = begin + 1; i < end; ++i) {
+            if (std::is_same<C, OperationAdd>::value) {
+                double y = data[i] - comp;
+                double t = r + y;
+                comp = (t - r) - y;
+                r = t;
+            } else {
+                r = C::apply(r, data[i]);
+            }
+            out[i] = r;
+        }
+    });
+}
+
+// out[i] = data[0] / (data[1] * ... * data[i]), 要求 n >= 2
+inline void divide_scan(const double* data, double* out, std::size_t n,
+                        unsigned threads) {
+    const double* divisors = data + 1;
+    std::size_t count = n - 1;
+    std::vector<ScaledProduct> totals =
+        divisor_products(divisors, count, threads);
+
+    // offsets[c] 为分块 c 之前所有除数的乘积
+    std::vector<ScaledProduct> offsets(totals.size());
+    ScaledProduct acc;
+    for (std::size_t c = 0; c < totals.size(); ++c) {
+        offsets[c] = acc;
+        acc.multiply(totals[c]);
+    }
+
+    out[0] = data[0];
+    parallel_for_chunks(totals.size(), threads, [&](std::size_t c) {
+        std::size_t begin = c * kReduceChunk;
+        std::size_t end = std::min(begin + kReduceChunk, count);
+        ScaledProduct p = offsets[c];
+        for (std::size_t i = begin; i < end; ++i) {
+            p.multiply(divisors[i]);
+            out[1 + i] = p.divide(data[0]);
+        }
+    });
+}
+
+template <class T>
+void parallel_scan(const double* data, double* out, std::size_t n,
+                   unsigned threads) {
+    using C = typename fold_combiner<T>::type;
+    if (n == 0) {
+        return;
+    }
+    if constexpr (std::is_same<T, OperationDiv>::value) {
+        if (n == 1) {
+            out[0] = data[0];
+        } else {
+            divide_scan(data, out, n, threads);
+        }
+        return;
+    }
+    if (std::is_same<C, T>::value) {
+        combine_scan<C>(data, out, n, threads);
+        return;
+    }
+    // 先对 data[1..] 扫描可结合运算, 再与首元素合并
+    out[0] = data[0];
+    if (n == 1) {
+        return;
+    }
+    combine_scan<C>(data + 1, out + 1, n - 1, threads);
+    double first = data[0];
+    parallel_for_chunks(
+        (n - 1 + kReduceChunk - 1) / kReduceChunk, threads, [&](std::size_t c) {
+            std::size_t begin = 1 + c * kReduceChunk;
+            std::size_t end = std::min(begin + kReduceChunk, n);
+            for (std::size_t i = begin; i < end; ++i) {
+                out[i] = T::apply(first, out[i]);
+            }
+        });
+}
+
+// 查找表的一项: 某个运算符对应的各种创建方式
+struct OperationEntry {
+    Operation* (*create)() = nullptr;
+    OperationPtr (*make)() = nullptr;
+    BatchKernel (*kernel)(BatchIsa) = nullptr;
+    ReduceKernel reduce = nullptr;
+    ScanKernel scan = nullptr;
 };
 
+template <class T>
+Operation* new_operation() {
+    return new T();
+}
+
+template <class T>
+constexpr OperationEntry operation_entry() {
+    if constexpr (std::is_void<T>::value) {
+        return OperationEntry{};
+    } else {
+        return OperationEntry{ &new_operation<T>, &make_pooled_operation<T>,
+                               &select_batch_kernel<T::symbol>,
+                               &parallel_reduce<T>, &parallel_scan<T> };
+    }
+}
+
+template <std::size_t... Cs>
+constexpr std::array<OperationEntry, 256>
+build_operation_table(std::index_sequence<Cs...>) {
+    return { { operation_entry<OperationOf<static_cast<char>(Cs)>>()... } };
+}
+
+// 以运算符为下标的稠密查找表, 编译期遍历所有已注册的运算符生成,
+// 查找为 O(1) 且无运行时分配
+constexpr std::array<OperationEntry, 256> kOperationTable =
+    build_operation_table(std::make_index_sequence<256>());
+
 class OperationFactory {
 public:
     static Operation* CreateOperation(char op) {
-        switch (op) {
-            case '+':
-                return new OperationAdd();
-            case '-':
-                return new OperationSub();
-            case '*':
-                return new OperationMul();
-            case '/':
-                return new OperationDiv();
-            default:
-                return nullptr;
-        }
+        const OperationEntry& entry =
+            kOperationTable[static_cast<unsigned char>(op)];
+        return entry.create ? entry.create() : nullptr;
+    }
+
+    // 池化创建: 返回拥有所有权的句柄, 不支持的运算符返回空句柄
+    static OperationPtr MakeOperation(char op) {
+        const OperationEntry& entry =
+            kOperationTable[static_cast<unsigned char>(op)];
+        return entry.make ? entry.make() : nullptr;
+    }
+
+    // 批量计算: 返回对整段操作数数组执行 op 的内核, 不支持的运算符返回 nullptr
+    static BatchKernel CreateBatchKernel(char op,
+                                         BatchIsa isa = BatchIsa::Best) {
+        const OperationEntry& entry =
+            kOperationTable[static_cast<unsigned char>(op)];
+        return entry.kernel ? entry.kernel(isa) : nullptr;
+    }
+
+    // 并行归约/扫描: 不支持的运算符返回 nullptr
+    static ReduceKernel CreateReducer(char op) {
+        return kOperationTable[static_cast<unsigned char>(op)].reduce;
+    }
+
+    static ScanKernel CreateScanner(char op) {
+        return kOperationTable[static_cast<unsigned char>(op)].scan;
+    }
+
+    // 静态分发: 运算符在编译期已知时直接解析到具体类型
+    template <char op>
+    static OperationPtr MakeOperation() {
+        static_assert(!std::is_void<OperationOf<op>>::value,
+                      "unregistered operation symbol");
+        return make_pooled_operation<OperationOf<op>>();
+    }
+
+    template <char op>
+    static BatchKernel CreateBatchKernel(BatchIsa isa = BatchIsa::Best) {
+        static_assert(!std::is_void<OperationOf<op>>::value,
+                      "unregistered operation symbol");
+        return select_batch_kernel<op>(isa);
     }
 };
 
+// 表达式模板: 把多个运算融合成一个内核, 求值时对输入数组只遍历一次.
+// 每个节点的运算语义与对应的 Operation 相同, 中间结果只存在于寄存器中.
+
+// 叶子: 操作数数组
+struct ArrayExpr {
+    const double* data;
+
+    double operator[](std::size_t i) const {
+        return data[i];
+    }
+};
+
+// 叶子: 标量常数
+struct ScalarExpr {
+    double value;
+
+    double operator[](std::size_t) const {
+        return value;
+    }
+};
+
+// 运算节点
+template <char op, class L, class R>
+struct BinaryExpr {
+    L lhs;
+    R rhs;
+
+    double operator[](std::size_t i) const {
+        return batch_apply<op>(lhs[i], rhs[i]);
+    }
+};
+
+template <class T>
+struct is_expr : std::false_type {};
+template <>
+struct is_expr<ArrayExpr> : std::true_type {};
+template <>
+struct is_expr<ScalarExpr> : std::true_type {};
+template <char op, class L, class R>
+struct is_expr<BinaryExpr<op, L, R>> : std::true_type {};
+
+inline ArrayExpr operand(const double* data) {
+    return ArrayExpr{ data };
+}
+
+inline ScalarExpr operand(double value) {
+    return ScalarExpr{ value };
+}
+
+// 操作数可以是表达式, 也可以直接是 double 常数
+template <class T>
+auto as_expr(const T& t) {
+    if constexpr (is_expr<T>::value) {
+        return t;
+    } else {
+        return ScalarExpr{ static_cast<double>(t) };
+    }
+}
+
+template <char op, class L, class R>
+auto make_expr(const L& lhs, const R& rhs) {
+    auto l = as_expr(lhs);
+    auto r = as_expr(rhs);
+    return BinaryExpr<op, decltype(l), decltype(r)>{ l, r };
+}
+
+template <class L, class R,
+          class = std::enable_if_t<is_expr<L>::value || is_expr<R>::value>>
+auto operator+(const L& lhs, const R& rhs) {
+    return make_expr<'+'>(lhs, rhs);
+}
+
+template <class L, class R,
+          class = std::enable_if_t<is_expr<L>::value || is_expr<R>::value>>
+auto operator-(const L& lhs, const R& rhs) {
+    return make_expr<'-'>(lhs, rhs);
+}
+
+template <class L, class R,
+          class = std::enable_if_t<is_expr<L>::value || is_expr<R>::value>>
+auto operator*(const L& lhs, const R& rhs) {
+    return make_expr<'*'>(lhs, rhs);
+}
+
+template <class L, class R,
+          class = std::enable_if_t<is_expr<L>::value || is_expr<R>::value>>
+auto operator/(const L& lhs, const R& rhs) {
+    return make_expr<'/'>(lhs, rhs);
+}
+
+// 融合求值: out[i] = expr[i], 整个表达式一次遍历完成
+template <class E>
+void evaluate(const E& expr, double* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = expr[i];
+    }
+}
+
+// 批量内核与逐个 Operation::get_result() 的结果校验及吞吐量对比
+void batch_benchmark(std::size_t n) {
+    std::vector<double> a(n), b(n), expect(n), out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        a[i] = 1.0 + static_cast<double>(i % 1000) * 0.37;
+        b[i] = 3.0 - static_cast<double>(i % 777) * 0.11;
+    }
+
+    const char ops[] = { '+', '-', '*', '/' };
+    const BatchIsa isas[] = { BatchIsa::Scalar, BatchIsa::Avx2,
+                              BatchIsa::Avx512 };
+    const char* isa_names[] = { "scalar", "avx2", "avx512" };
+
+    for (char op: ops) {
+        // 基准: 每个元素一次虚函数调用
+        Operation* operation = OperationFactory::CreateOperation(op);
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < n; ++i) {
+            operation->number_1 = a[i];
+            operation->number_2 = b[i];
+            expect[i] = operation->get_result();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        delete operation;
+        double base_ns =
+            std::chrono::duration<double, std::nano>(stop - start).count();
+        std::cout << "op '" << op << "' virtual: " << base_ns / n
+                  << " ns/elem" << std::endl;
+
+        for (std::size_t k = 0; k < 3; ++k) {
+            BatchKernel kernel =
+                OperationFactory::CreateBatchKernel(op, isas[k]);
+            if (!kernel) {
+                std::cout << "  " << isa_names[k] << ": unsupported"
+                          << std::endl;
+                continue;
+            }
+            start = std::chrono::steady_clock::now();
+            kernel(a.data(), b.data(), out.data(), n);
+            stop = std::chrono::steady_clock::now();
+            double ns =
+                std::chrono::duration<double, std::nano>(stop - start).count();
+            bool exact = std::memcmp(out.data(), expect.data(),
+                                     n * sizeof(double)) == 0;
+            std::cout << "  " << isa_names[k] << ": " << ns / n
+                      << " ns/elem, speedup " << base_ns / ns
+                      << (exact ? ", bit-exact" : ", MISMATCH") << std::endl;
+        }
+    }
+}
+
+// 对象池与 new/delete 的分配次数及单次创建+销毁延迟对比
+void pool_benchmark(std::size_t n) {
+    const char ops[] = { '+', '-', '*', '/' };
+    double sink = 0;
+
+    // 预热: 让每种类型的池至少拥有一个块
+    for (char op: ops) {
+        OperationFactory::MakeOperation(op);
+    }
+
+    std::size_t allocs = g_heap_allocs.load();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        Operation* operation = OperationFactory::CreateOperation(ops[i & 3]);
+        operation->number_1 = static_cast<double>(i);
+        operation->number_2 = 2;
+        sink += operation->get_result();
+        delete operation;
+    }
+    auto stop = std::chrono::steady_clock::now();
+    std::cout << "new/delete: "
+              << std::chrono::duration<double, std::nano>(stop - start)
+                         .count() /
+                     n
+              << " ns/op, " << g_heap_allocs.load() - allocs << " allocs"
+              << std::endl;
+
+    allocs = g_heap_allocs.load();
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        OperationPtr operation = OperationFactory::MakeOperation(ops[i & 3]);
+        operation->number_1 = static_cast<double>(i);
+        operation->number_2 = 2;
+        sink += operation->get_result();
+    }
+    stop = std::chrono::steady_clock::now();
+    std::cout << "pool:       "
+              << std::chrono::duration<double, std::nano>(stop - start)
+                         .count() /
+                     n
+              << " ns/op, " << g_heap_allocs.load() - allocs << " allocs"
+              << std::endl;
+
+    // 另一个线程创建、本线程销毁: 本地链表有上限, 多余槽位归还全局
+    std::vector<OperationPtr> handed_over;
+    std::thread producer([&handed_over, n] {
+        for (std::size_t i = 0; i < n / 64; ++i) {
+            handed_over.push_back(make_pooled_operation<OperationAdd>());
+        }
+    });
+    producer.join();
+    handed_over.clear();
+    std::size_t chunks = OperationPool<OperationAdd>::chunk_count();
+    std::size_t released = OperationPool<OperationAdd>::trim();
+    std::cout << "cross-thread: " << n / 64 << " objects, released "
+              << released << " of " << chunks << " chunks" << std::endl;
+
+    std::cout << "checksum: " << sink << std::endl;
+}
+
+// (a + b) * c / d: 逐步调用批量内核(两个临时数组) 与融合求值的对比
+void fused_benchmark(std::size_t n) {
+    std::vector<double> a(n), b(n), c(n), d(n), t1(n), t2(n), staged(n),
+        fused(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        a[i] = static_cast<double>(i % 100) * 0.5;
+        b[i] = 1.25;
+        c[i] = static_cast<double>(i % 7) + 1.0;
+        d[i] = static_cast<double>(i % 13) + 2.0;
+    }
+
+    BatchKernel add = OperationFactory::CreateBatchKernel('+');
+    BatchKernel mul = OperationFactory::CreateBatchKernel('*');
+    BatchKernel div = OperationFactory::CreateBatchKernel('/');
+
+    auto start = std::chrono::steady_clock::now();
+    add(a.data(), b.data(), t1.data(), n);
+    mul(t1.data(), c.data(), t2.data(), n);
+    div(t2.data(), d.data(), staged.data(), n);
+    auto stop = std::chrono::steady_clock::now();
+    double staged_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+
+    auto expr = (operand(a.data()) + operand(b.data())) * operand(c.data()) /
+                operand(d.data());
+    start = std::chrono::steady_clock::now();
+    evaluate(expr, fused.data(), n);
+    stop = std::chrono::steady_clock::now();
+    double fused_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+
+    // 逐步计算: 每步读 2 个数组写 1 个; 融合: 读 4 个数组写 1 个
+    std::size_t staged_bytes = 3 * 3 * n * sizeof(double);
+    std::size_t fused_bytes = 5 * n * sizeof(double);
+    bool exact = std::memcmp(staged.data(), fused.data(),
+                             n * sizeof(double)) == 0;
+    std::cout << "staged: " << staged_ns / n << " ns/elem, "
+              << staged_bytes / (1 << 20) << " MiB traffic" << std::endl;
+    std::cout << "fused:  " << fused_ns / n << " ns/elem, "
+              << fused_bytes / (1 << 20) << " MiB traffic"
+              << (exact ? ", bit-exact" : ", MISMATCH") << std::endl;
+}
+
+// 逐对调用 get_result() 的串行折叠与并行归约的对比(1 到 N 个线程)
+void reduce_benchmark(std::size_t n) {
+    std::vector<double> data(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        data[i] = 0.1 + static_cast<double>(i % 10) * 1e-9;
+    }
+
+    OperationPtr add = OperationFactory::MakeOperation('+');
+    auto start = std::chrono::steady_clock::now();
+    add->number_1 = data[0];
+    for (std::size_t i = 1; i < n; ++i) {
+        add->number_2 = data[i];
+        add->number_1 = add->get_result();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double serial_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    std::cout << "serial sum:   " << std::setprecision(17) << add->number_1
+              << std::setprecision(6) << ", "
+              << serial_ns / 1e6 << " ms" << std::endl;
+
+    ReduceKernel reduce = OperationFactory::CreateReducer('+');
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    reduce(data.data(), n, max_threads); // 预热: 创建常驻工作线程
+    for (unsigned t = 1; t <= max_threads; ++t) {
+        start = std::chrono::steady_clock::now();
+        double sum = reduce(data.data(), n, t);
+        stop = std::chrono::steady_clock::now();
+        double ns =
+            std::chrono::duration<double, std::nano>(stop - start).count();
+        std::cout << "parallel sum: " << std::setprecision(17) << sum
+                  << std::setprecision(6) << ", " << ns / 1e6 << " ms, "
+                  << t << " threads, speedup " << serial_ns / ns
+                  << std::endl;
+    }
+}
+
 int main(int argc, char* argv[]) {
     // 加法
     char op = '+';
-    Operation* operation = OperationFactory::CreateOperation(op);
+    OperationPtr operation = OperationFactory::MakeOperation(op);
     operation->number_1 = 10;
     operation->number_2 = 5;
     std::cout << "Result: " << operation->get_result() << std::endl;
 
     // 减法
     op = '-';
-    operation = OperationFactory::CreateOperation(op);
+    operation = OperationFactory::MakeOperation(op);
     operation->number_1 = 10;
     operation->number_2 = 5;
     std::cout << "Result: " << operation->get_result() << std::endl;
 
     // 乘法
     op = '*';
-    operation = OperationFactory::CreateOperation(op);
+    operation = OperationFactory::MakeOperation(op);
     operation->number_1 = 10;
     operation->number_2 = 5;
     std::cout << "Result: " << operation->get_result() << std::endl;
 
     // 除法
     op = '/';
-    operation = OperationFactory::CreateOperation(op);
+    operation = OperationFactory::MakeOperation(op);
     operation->number_1 = 10;
     operation->number_2 = 5;
     std::cout << "Result: " << operation->get_result() << std::endl;
 
+    // 静态分发
+    OperationPtr add = OperationFactory::MakeOperation<'+'>();
+    add->number_1 = 1;
+    add->number_2 = 2;
+    std::cout << "Static result: " << add->get_result() << std::endl;
+
+    // 批量计算
+    double lhs[] = { 10, 20, 30, 40, 50 };
+    double rhs[] = { 5, 4, 3, 2, 1 };
+    double res[5];
+    BatchKernel kernel = OperationFactory::CreateBatchKernel('*');
+    kernel(lhs, rhs, res, 5);
+    for (double r: res) {
+        std::cout << "Batch result: " << r << std::endl;
+    }
+
+    batch_benchmark(1 << 20);
+    pool_benchmark(1 << 22);
+
+    // 融合求值 (a + b) * c / d
+    double c3[] = { 2, 2, 2, 2, 2 };
+    auto formula = (operand(lhs) + operand(rhs)) * operand(c3) / 3.0;
+    evaluate(formula, res, 5);
+    for (double r: res) {
+        std::cout << "Fused result: " << r << std::endl;
+    }
+
+    fused_benchmark(1 << 22);
+
+    // 并行归约与扫描
+    double values[] = { 100, 1, 2, 3, 4 };
+    std::cout << "Reduce '-': "
+              << OperationFactory::CreateReducer('-')(values, 5, 0)
+              << std::endl;
+    OperationFactory::CreateScanner('+')(values, res, 5, 0);
+    for (double r: res) {
+        std::cout << "Scan '+': " << r << std::endl;
+    }
+
+    reduce_benchmark(1 << 24);
+
     return 0;
 }
\ No newline at end of file
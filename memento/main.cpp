@@ -27,9 +27,33 @@
  *
  */
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define MEMENTO_HAS_MMAP 1
+#else
+#define MEMENTO_HAS_MMAP 0
+#endif
 
 /**
  * 备忘录模式的用途：
@@ -59,7 +83,20 @@
  * 3. `CareTaker` 类：
  *    - 存储 `Memento` 的实例. 
  *    - 提供了保存和获取备忘录的接口. 
- * 4. 主函数演示：
+ * 4. `Originator::DeltaMemento`：
+ *    - 增量备忘录, 只保存与上一个快照之间的二进制差异, 
+ *      每隔若干个快照保存一个完整关键帧, 
+ *      恢复时从最近的关键帧依次应用差异, 恢复代价受关键帧间隔限制. 
+ * 5. `RopeOriginator`：
+ *    - 状态保存在持久化分块树(`cow::Rope`)中, 编辑只复制被修改的路径, 
+ *      备忘录共享未修改的块, 创建与恢复备忘录都只需复制根指针. 
+ * 6. `HistoryCareTaker`：
+ *    - 在内存预算内保存多个快照: 最近的快照不压缩, 较旧的用 LZ4 风格的压缩
+ *      保存在内存, 最旧的溢出到 mmap 映射的文件, 并按层级统计命中延迟. 
+ * 7. `AsyncSnapshotter`：
+ *    - 调用方只冻结 `RopeOriginator` 的一个不可变版本, 
+ *      序列化与压缩在后台线程完成, 发起者在此期间继续接受修改. 
+ * 8. 主函数演示：
  *    - 保存发起者的状态到备忘录, 改变状态后通过管理者恢复之前的状态. 
  *
  * 优势：
@@ -77,6 +114,178 @@
  * - 需要对状态变化进行跟踪和管理. 
  */
 
+// 二进制差异编码: 目标由若干 "从基准复制" 与 "字面量" 片段组成.
+// 对基准按固定块建立哈希索引, 用滚动哈希扫描目标寻找匹配块,
+// 匹配后向前后延伸, 因此插入/删除导致的偏移也能被识别.
+// 编码格式: 'C' [offset u32][len u32] 或 'L' [len u32][bytes]
+namespace delta {
+constexpr std::size_t kBlock = 32;
+constexpr std::uint64_t kBase = 1099511628211ULL;
+
+inline void put_u32(std::string& out, std::uint32_t v) {
+    char b[4];
+    std::memcpy(b, &v, 4);
+    out.append(b, 4);
+}
+
+inline std::uint32_t get_u32(const char* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline std::uint64_t hash_block(const char* p) {
+    std::uint64_t h = 0;
+    for (std::size_t i = 0; i < kBlock; ++i) {
+        h = h * kBase + static_cast<unsigned char>(p[i]);
+    }
+    return h;
+}
+
+inline void flush_literal(std::string& out, const std::string& target,
+                          std::size_t begin, std::size_t end) {
+    if (end > begin) {
+        out += 'L';
+        put_u32(out, static_cast<std::uint32_t>(end - begin));
+        out.append(target, begin, end - begin);
+    }
+}
+
+inline void put_copy(std::string& out, std::size_t src, std::size_t len) {
+    if (len > 0) {
+        out += 'C';
+        put_u32(out, static_cast<std::uint32_t>(src));
+        put_u32(out, static_cast<std::uint32_t>(len));
+    }
+}
+
+// a 与 b 的前 n 个字节中相同前缀的长度, 按 64 字节一段用 memcmp 比较
+inline std::size_t common_prefix(const char* a, const char* b,
+                                 std::size_t n) {
+    std::size_t i = 0;
+    while (i + 64 <= n && std::memcmp(a + i, b + i, 64) == 0) {
+        i += 64;
+    }
+    while (i < n && a[i] == b[i]) {
+        ++i;
+    }
+    return i;
+}
+
+// 以 a_end 与 b_end 结尾的两段中相同后缀的长度, 最多 n 个字节
+inline std::size_t common_suffix(const char* a_end, const char* b_end,
+                                 std::size_t n) {
+    std::size_t i = 0;
+    while (i + 64 <= n &&
+           std::memcmp(a_end - i - 64, b_end - i - 64, 64) == 0) {
+        i += 64;
+    }
+    while (i < n && a_end[-1 - static_cast<std::ptrdiff_t>(i)] ==
+                        b_end[-1 - static_cast<std::ptrdiff_t>(i)]) {
+        ++i;
+    }
+    return i;
+}
+
+// 用滚动哈希把 target[begin, end) 编码为对 base 的复制与字面量,
+// 只对 base[base_begin, base_end) 建立块索引
+inline void encode_range(const std::string& base, std::size_t base_begin,
+                         std::size_t base_end, const std::string& target,
+                         std::size_t begin, std::size_t end,
+                         std::string& out) {
+    std::unordered_map<std::uint64_t, std::uint32_t> index;
+    if (end - begin >= kBlock) {
+        index.reserve((base_end - base_begin) / kBlock + 1);
+        for (std::size_t i = base_begin; i + kBlock <= base_end; i += kBlock) {
+            index.emplace(hash_block(base.data() + i),
+                          static_cast<std::uint32_t>(i));
+        }
+    }
+
+    std::uint64_t top = 1; // kBase^(kBlock-1), 用于移出窗口首字节
+    for (std::size_t i = 1; i < kBlock; ++i) {
+        top *= kBase;
+    }
+
+    std::size_t literal = begin; // 尚未输出的字面量起点
+    std::size_t i = begin;
+    std::uint64_t h = 0;
+    bool valid = false;
+    while (!index.empty() && i + kBlock <= end) {
+        if (!valid) {
+            h = hash_block(target.data() + i);
+            valid = true;
+        }
+        auto it = index.find(h);
+        if (it != index.end() &&
+            std::memcmp(base.data() + it->second, target.data() + i,
+                        kBlock) == 0) {
+            std::size_t src = it->second;
+            std::size_t dst = i;
+            // 向前延伸, 吃掉待输出字面量的尾部
+            while (dst > literal && src > 0 &&
+                   base[src - 1] == target[dst - 1]) {
+                --src;
+                --dst;
+            }
+            std::size_t len = i + kBlock - dst;
+            while (src + len < base.size() && dst + len < end &&
+                   base[src + len] == target[dst + len]) {
+                ++len;
+            }
+            flush_literal(out, target, literal, dst);
+            put_copy(out, src, len);
+            i = dst + len;
+            literal = i;
+            valid = false;
+            continue;
+        }
+        if (i + kBlock < end) {
+            h = (h - top * static_cast<unsigned char>(target[i])) * kBase +
+                static_cast<unsigned char>(target[i + kBlock]);
+        }
+        ++i;
+    }
+    flush_literal(out, target, literal, end);
+}
+
+// 生成把 base 变为 target 的差异. 相同的前缀和后缀直接输出为复制指令,
+// 只对两者之间变化的区域建立索引和计算滚动哈希, 一次局部编辑的代价是
+// 一遍 memcmp 加上变化区域的大小, 而不是对整个 base 重新建立索引.
+inline std::string encode(const std::string& base, const std::string& target) {
+    std::size_t limit = std::min(base.size(), target.size());
+    std::size_t prefix = common_prefix(base.data(), target.data(), limit);
+    std::size_t suffix = common_suffix(base.data() + base.size(),
+                                       target.data() + target.size(),
+                                       limit - prefix);
+    std::string out;
+    put_copy(out, 0, prefix);
+    encode_range(base, prefix, base.size() - suffix, target, prefix,
+                 target.size() - suffix, out);
+    put_copy(out, base.size() - suffix, suffix);
+    return out;
+}
+
+// 在 base 上应用差异得到目标
+inline std::string apply(const std::string& base, const std::string& diff) {
+    std::string out;
+    out.reserve(base.size() + diff.size());
+    std::size_t i = 0;
+    while (i < diff.size()) {
+        char op = diff[i];
+        if (op == 'C') {
+            out.append(base, get_u32(&diff[i + 1]), get_u32(&diff[i + 5]));
+            i += 9;
+        } else {
+            std::uint32_t len = get_u32(&diff[i + 1]);
+            out.append(diff, i + 5, len);
+            i += 5 + len;
+        }
+    }
+    return out;
+}
+}
+
 // 发起者类
 class Originator {
 private:
@@ -92,7 +301,8 @@ public:
         Memento(std::string state) : state(state) {
         }
 
-        std::string getState() {
+        // 返回引用: 管理者读取大小或压缩快照时不必复制整份状态
+        const std::string& getState() const {
             return state;
         }
     };
@@ -107,6 +317,77 @@ public:
         this->state = memento->getState();
     }
 
+    // 增量备忘录: 关键帧保存完整状态, 其余只保存相对上一个快照的差异
+    class DeltaMemento {
+    private:
+        std::shared_ptr<const DeltaMemento> base; // 关键帧为空
+        std::string data;                         // 完整状态或差异
+        std::size_t depth;                        // 距关键帧的差异个数
+
+    public:
+        DeltaMemento(std::shared_ptr<const DeltaMemento> base,
+                     std::string data) :
+            base(std::move(base)), data(std::move(data)) {
+            depth = this->base ? this->base->depth + 1 : 0;
+        }
+
+        // 从关键帧开始依次应用差异, 最多应用 "关键帧间隔 - 1" 个
+        std::string getState() const {
+            std::vector<const DeltaMemento*> chain;
+            for (const DeltaMemento* m = this; m; m = m->base.get()) {
+                chain.push_back(m);
+            }
+            std::string result = chain.back()->data;
+            for (std::size_t i = chain.size() - 1; i-- > 0;) {
+                result = delta::apply(result, chain[i]->data);
+            }
+            return result;
+        }
+
+        bool is_keyframe() const {
+            return !base;
+        }
+
+        std::size_t get_depth() const {
+            return depth;
+        }
+
+        // 本备忘录自身占用的字节数(不含共享的基准)
+        std::size_t size_bytes() const {
+            return data.size();
+        }
+    };
+
+private:
+    std::size_t keyframe_interval = 16;
+    std::shared_ptr<const DeltaMemento> last_delta; // 上一个增量快照
+    std::string last_delta_state;                   // 其对应的完整状态
+
+public:
+    // 每 interval 个增量快照保存一个关键帧
+    void set_keyframe_interval(std::size_t interval) {
+        keyframe_interval = interval ? interval : 1;
+    }
+
+    // 创建增量备忘录
+    std::shared_ptr<const DeltaMemento> create_delta_memento() {
+        std::shared_ptr<const DeltaMemento> memento;
+        if (!last_delta || last_delta->get_depth() + 1 >= keyframe_interval) {
+            memento = std::make_shared<const DeltaMemento>(nullptr, state);
+        } else {
+            memento = std::make_shared<const DeltaMemento>(
+                last_delta, delta::encode(last_delta_state, state));
+        }
+        last_delta = memento;
+        last_delta_state = state;
+        return memento;
+    }
+
+    // 恢复增量备忘录
+    void restore_memento(const std::shared_ptr<const DeltaMemento>& memento) {
+        this->state = memento->getState();
+    }
+
     // 显示当前状态
     void show_state() {
         std::cout << "Current state: " << this->state << std::endl;
@@ -123,6 +404,315 @@ public:
     }
 };
 
+// 持久化(不可变)分块树: 叶子保存不超过 kLeafMax 字节的文本块, 内部节点最多
+// kFanout 个孩子. 节点创建后不再修改, 编辑时只复制从根到被修改叶子的路径,
+// 其余子树在新旧版本之间共享. 因此保存一个版本只需复制根指针.
+namespace cow {
+constexpr std::size_t kLeafMax = 4096;
+constexpr std::size_t kFanout = 32;
+
+struct Node;
+using NodePtr = std::shared_ptr<const Node>;
+
+struct Node {
+    bool leaf;
+    std::size_t size;              // 子树文本总长度
+    std::string text;              // 仅叶子使用
+    std::vector<NodePtr> children; // 仅内部节点使用
+};
+
+inline NodePtr make_leaf(std::string text) {
+    auto node = std::make_shared<Node>();
+    node->leaf = true;
+    node->size = text.size();
+    node->text = std::move(text);
+    return node;
+}
+
+inline NodePtr make_internal(std::vector<NodePtr> children) {
+    auto node = std::make_shared<Node>();
+    node->leaf = false;
+    node->size = 0;
+    for (const NodePtr& child: children) {
+        node->size += child->size;
+    }
+    node->children = std::move(children);
+    return node;
+}
+
+// 把文本切成若干个叶子, 每块不超过 kLeafMax 且尽量均匀
+inline std::vector<NodePtr> make_leaves(const std::string& text) {
+    std::vector<NodePtr> leaves;
+    std::size_t count = (text.size() + kLeafMax - 1) / kLeafMax;
+    for (std::size_t i = 0, begin = 0; i < count; ++i) {
+        std::size_t end = text.size() * (i + 1) / count;
+        leaves.push_back(make_leaf(text.substr(begin, end - begin)));
+        begin = end;
+    }
+    return leaves;
+}
+
+// 把同一层的节点分组, 每组不超过 kFanout 个孩子
+inline std::vector<NodePtr> pack(const std::vector<NodePtr>& nodes) {
+    if (nodes.size() <= kFanout) {
+        return { make_internal(nodes) };
+    }
+    std::vector<NodePtr> groups;
+    std::size_t count = (nodes.size() + kFanout - 1) / kFanout;
+    for (std::size_t i = 0, begin = 0; i < count; ++i) {
+        std::size_t end = nodes.size() * (i + 1) / count;
+        groups.push_back(make_internal(std::vector<NodePtr>(
+            nodes.begin() + begin, nodes.begin() + end)));
+        begin = end;
+    }
+    return groups;
+}
+
+// 在 pos 处插入, 返回替换原节点的一个或多个(分裂后)节点
+inline std::vector<NodePtr> insert(const NodePtr& node, std::size_t pos,
+                                   const std::string& text) {
+    if (node->leaf) {
+        std::string merged = node->text.substr(0, pos);
+        merged += text;
+        merged.append(node->text, pos, std::string::npos);
+        if (merged.size() <= kLeafMax) {
+            return { make_leaf(std::move(merged)) };
+        }
+        return make_leaves(merged);
+    }
+    std::size_t i = 0;
+    while (i + 1 < node->children.size() && pos > node->children[i]->size) {
+        pos -= node->children[i]->size;
+        ++i;
+    }
+    std::vector<NodePtr> replaced = insert(node->children[i], pos, text);
+    std::vector<NodePtr> children;
+    children.reserve(node->children.size() + replaced.size());
+    children.insert(children.end(), node->children.begin(),
+                    node->children.begin() + i);
+    children.insert(children.end(), replaced.begin(), replaced.end());
+    children.insert(children.end(), node->children.begin() + i + 1,
+                    node->children.end());
+    return pack(children);
+}
+
+// 叶子不足 kLeafMax / 2 字节或内部节点不足 kFanout / 2 个孩子时视为过小
+inline bool underfull(const NodePtr& node) {
+    return node->leaf ? node->size < kLeafMax / 2
+                      : node->children.size() < kFanout / 2;
+}
+
+// 把过小的节点与左邻居合并, 合并后超出上限的重新均分为两个节点.
+// 同一层的节点高度相同, 因此内部节点可以直接拼接孩子列表.
+inline std::vector<NodePtr> merge_small(std::vector<NodePtr> nodes) {
+    std::vector<NodePtr> out;
+    out.reserve(nodes.size());
+    for (NodePtr& node: nodes) {
+        if (out.empty() || !(underfull(out.back()) || underfull(node))) {
+            out.push_back(std::move(node));
+            continue;
+        }
+        NodePtr prev = std::move(out.back());
+        out.pop_back();
+        std::vector<NodePtr> merged;
+        if (node->leaf) {
+            merged = make_leaves(prev->text + node->text);
+        } else {
+            std::vector<NodePtr> children = prev->children;
+            children.insert(children.end(), node->children.begin(),
+                            node->children.end());
+            merged = pack(children);
+        }
+        out.insert(out.end(), merged.begin(), merged.end());
+    }
+    return out;
+}
+
+// 删除 [pos, pos + len), 子树变空时返回空指针.
+// 每一层删除后合并过小的相邻节点, 避免反复删除留下大量碎片节点.
+inline NodePtr erase(const NodePtr& node, std::size_t pos, std::size_t len) {
+    if (node->leaf) {
+        if (pos == 0 && len >= node->size) {
+            return nullptr;
+        }
+        std::string text = node->text;
+        text.erase(pos, len);
+        return make_leaf(std::move(text));
+    }
+    std::vector<NodePtr> children;
+    children.reserve(node->children.size());
+    std::size_t offset = 0;
+    for (const NodePtr& child: node->children) {
+        std::size_t begin = offset;
+        std::size_t end = offset + child->size;
+        offset = end;
+        if (end <= pos || begin >= pos + len) {
+            children.push_back(child);
+            continue;
+        }
+        std::size_t from = pos > begin ? pos - begin : 0;
+        std::size_t to = std::min(end, pos + len) - begin;
+        if (NodePtr kept = erase(child, from, to - from)) {
+            children.push_back(std::move(kept));
+        }
+    }
+    if (children.empty()) {
+        return nullptr;
+    }
+    return make_internal(merge_small(std::move(children)));
+}
+
+inline void append_to(const NodePtr& node, std::string& out) {
+    if (node->leaf) {
+        out += node->text;
+        return;
+    }
+    for (const NodePtr& child: node->children) {
+        append_to(child, out);
+    }
+}
+
+// 统计一组版本实际占用的字节数, 共享的节点只计一次
+inline std::size_t unique_bytes(const NodePtr& node,
+                                std::unordered_set<const Node*>& seen) {
+    if (!node || !seen.insert(node.get()).second) {
+        return 0;
+    }
+    std::size_t bytes = sizeof(Node) + node->text.capacity() +
+                        node->children.capacity() * sizeof(NodePtr);
+    for (const NodePtr& child: node->children) {
+        bytes += unique_bytes(child, seen);
+    }
+    return bytes;
+}
+
+// 持久化文本: 值语义, 拷贝只复制根指针, 编辑返回后旧版本保持不变
+class Rope {
+private:
+    NodePtr root;
+
+public:
+    Rope() = default;
+
+    explicit Rope(const std::string& text) {
+        assign(text);
+    }
+
+    void assign(const std::string& text) {
+        root = nullptr;
+        if (text.empty()) {
+            return;
+        }
+        std::vector<NodePtr> level = make_leaves(text);
+        while (level.size() > 1) {
+            level = pack(level);
+        }
+        root = level.front();
+    }
+
+    std::size_t size() const {
+        return root ? root->size : 0;
+    }
+
+    void insert(std::size_t pos, const std::string& text) {
+        if (text.empty()) {
+            return;
+        }
+        if (!root) {
+            assign(text);
+            return;
+        }
+        std::vector<NodePtr> level = cow::insert(root, pos, text);
+        while (level.size() > 1) {
+            level = pack(level);
+        }
+        root = level.front();
+    }
+
+    void erase(std::size_t pos, std::size_t len) {
+        if (!root || len == 0 || pos >= root->size) {
+            return;
+        }
+        root = cow::erase(root, pos, std::min(len, root->size - pos));
+        // 根只剩一个孩子时降低树高
+        while (root && !root->leaf && root->children.size() == 1) {
+            root = root->children.front();
+        }
+    }
+
+    void replace(std::size_t pos, std::size_t len, const std::string& text) {
+        erase(pos, len);
+        insert(pos, text);
+    }
+
+    std::string str() const {
+        std::string out;
+        out.reserve(size());
+        if (root) {
+            append_to(root, out);
+        }
+        return out;
+    }
+
+    const NodePtr& tree() const {
+        return root;
+    }
+};
+}
+
+// 基于持久化文本的发起者: 备忘录只持有某个版本的根, 创建与恢复都是 O(1),
+// N 个备忘录占用的内存与累计修改量成正比, 而不是 N 倍的状态大小
+class RopeOriginator {
+private:
+    cow::Rope state;
+
+public:
+    class Memento {
+    private:
+        cow::Rope state;
+
+    public:
+        explicit Memento(cow::Rope state) : state(std::move(state)) {
+        }
+
+        const cow::Rope& getState() const {
+            return state;
+        }
+    };
+
+    std::shared_ptr<const Memento> create_memento() const {
+        return std::make_shared<const Memento>(state);
+    }
+
+    void restore_memento(const std::shared_ptr<const Memento>& memento) {
+        state = memento->getState();
+    }
+
+    void set_state(const std::string& text) {
+        state.assign(text);
+    }
+
+    void insert(std::size_t pos, const std::string& text) {
+        state.insert(pos, text);
+    }
+
+    void erase(std::size_t pos, std::size_t len) {
+        state.erase(pos, len);
+    }
+
+    void replace(std::size_t pos, std::size_t len, const std::string& text) {
+        state.replace(pos, len, text);
+    }
+
+    std::size_t size() const {
+        return state.size();
+    }
+
+    std::string get_state() const {
+        return state.str();
+    }
+};
+
 // 管理者类
 class CareTaker {
 private:
@@ -140,6 +730,743 @@ public:
     }
 };
 
+// LZ4 风格的块压缩: 序列由 token(高 4 位字面量长度, 低 4 位匹配长度 - 4)、
+// 字面量、16 位回溯偏移与扩展长度组成, 用 4 字节哈希表查找候选匹配.
+// 压缩结果前 4 字节记录原始长度
+namespace lz {
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kHashBits = 14;
+constexpr std::size_t kMaxOffset = 65535;
+
+inline std::uint32_t read32(const char* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline std::uint32_t hash4(std::uint32_t v) {
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+inline void put_length(std::string& out, std::size_t len) {
+    while (len >= 255) {
+        out += static_cast<char>(255);
+        len -= 255;
+    }
+    out += static_cast<char>(len);
+}
+
+// 输出一个序列, match 为 0 表示只有字面量的最后一个序列
+inline void put_sequence(std::string& out, const char* literal,
+                         std::size_t literal_len, std::size_t offset,
+                         std::size_t match) {
+    std::size_t match_code = match ? match - kMinMatch : 0;
+    out += static_cast<char>((std::min<std::size_t>(literal_len, 15) << 4) |
+                             std::min<std::size_t>(match_code, 15));
+    if (literal_len >= 15) {
+        put_length(out, literal_len - 15);
+    }
+    out.append(literal, literal_len);
+    if (match) {
+        out += static_cast<char>(offset & 0xff);
+        out += static_cast<char>(offset >> 8);
+        if (match_code >= 15) {
+            put_length(out, match_code - 15);
+        }
+    }
+}
+
+inline std::string compress(const std::string& in) {
+    std::string out;
+    out.reserve(in.size() / 2 + 16);
+    delta::put_u32(out, static_cast<std::uint32_t>(in.size()));
+    std::vector<std::uint32_t> table(std::size_t(1) << kHashBits, 0);
+    const char* src = in.data();
+    std::size_t n = in.size();
+    // 与 LZ4 一样, 末尾 12 字节内不开始匹配, 最后 5 字节总是字面量
+    std::size_t limit = n > 12 ? n - 12 : 0;
+    std::size_t anchor = 0;
+    std::size_t i = 0;
+    while (i < limit) {
+        std::uint32_t seq = read32(src + i);
+        std::uint32_t h = hash4(seq);
+        std::size_t candidate = table[h];
+        table[h] = static_cast<std::uint32_t>(i);
+        if (candidate < i && i - candidate <= kMaxOffset &&
+            read32(src + candidate) == seq) {
+            std::size_t len = kMinMatch;
+            while (i + len < n - 5 && src[candidate + len] == src[i + len]) {
+                ++len;
+            }
+            put_sequence(out, src + anchor, i - anchor, i - candidate, len);
+            i += len;
+            anchor = i;
+        } else {
+            // 长时间没有匹配时加大步长, 快速跳过不可压缩的数据
+            i += 1 + ((i - anchor) >> 6);
+        }
+    }
+    put_sequence(out, src + anchor, n - anchor, 0, 0);
+    return out;
+}
+
+inline std::size_t get_length(const unsigned char* p, std::size_t& pos) {
+    std::size_t len = 0;
+    unsigned char b;
+    do {
+        b = p[pos++];
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+inline std::string decompress(const char* data, std::size_t size) {
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+    std::string out(delta::get_u32(data), '\0');
+    std::size_t pos = 4;
+    std::size_t o = 0;
+    while (pos < size) {
+        unsigned char token = p[pos++];
+        std::size_t literal_len = token >> 4;
+        if (literal_len == 15) {
+            literal_len += get_length(p, pos);
+        }
+        std::memcpy(&out[o], data + pos, literal_len);
+        pos += literal_len;
+        o += literal_len;
+        if (pos >= size) {
+            break;
+        }
+        std::size_t offset = p[pos] | (p[pos + 1] << 8);
+        pos += 2;
+        std::size_t match = (token & 15) + kMinMatch;
+        if ((token & 15) == 15) {
+            match += get_length(p, pos);
+        }
+        // 偏移小于匹配长度时(重复模式)源与目标重叠, 必须逐字节复制
+        if (offset >= match) {
+            std::memcpy(&out[o], &out[o - offset], match);
+            o += match;
+        } else {
+            for (std::size_t k = 0; k < match; ++k, ++o) {
+                out[o] = out[o - offset];
+            }
+        }
+    }
+    return out;
+}
+}
+
+// 分层的多快照管理者: 最近的快照不压缩直接保存(热), 较旧的快照压缩后
+// 留在内存(温), 内存超出预算时最旧的压缩快照追加到文件并通过 mmap 读取(冷).
+// 快照按时间老化, 因此三个层级在下标上是连续的: [冷 | 温 | 热]
+class HistoryCareTaker {
+public:
+    enum class Tier { Hot, Warm, Cold };
+
+    struct TierStats {
+        std::size_t snapshots = 0;
+        std::size_t bytes = 0;
+        std::size_t hits = 0;
+        double hit_ns = 0;
+    };
+
+private:
+    struct Entry {
+        std::shared_ptr<Originator::Memento> memento; // 热
+        std::string packed;                           // 温: 压缩数据
+        std::uint64_t offset = 0;                     // 冷: 文件中的位置
+        std::uint32_t length = 0;
+        std::size_t raw_size = 0;
+    };
+
+    std::vector<Entry> entries;
+    std::size_t cold_end = 0;  // [0, cold_end) 在磁盘
+    std::size_t warm_end = 0;  // [cold_end, warm_end) 压缩在内存
+    std::size_t hot_limit;
+    std::size_t memory_budget; // 热 + 温层的字节预算
+    std::size_t memory = 0;
+    TierStats stats[3];
+
+    std::string spill_dir;
+#if MEMENTO_HAS_MMAP
+    int fd = -1;
+    std::uint64_t file_size = 0;
+    void* mapped = MAP_FAILED;
+    std::size_t mapped_size = 0;
+#endif
+
+    TierStats& stat(Tier tier) {
+        return stats[static_cast<int>(tier)];
+    }
+
+    // 最旧的热快照压缩为温快照
+    void demote_hot() {
+        Entry& entry = entries[warm_end++];
+        entry.packed = lz::compress(entry.memento->getState());
+        entry.packed.shrink_to_fit();
+        entry.memento.reset();
+        memory -= entry.raw_size;
+        memory += entry.packed.size();
+        stat(Tier::Hot).snapshots--;
+        stat(Tier::Hot).bytes -= entry.raw_size;
+        stat(Tier::Warm).snapshots++;
+        stat(Tier::Warm).bytes += entry.packed.size();
+    }
+
+#if MEMENTO_HAS_MMAP
+    // 最旧的温快照追加写入溢出文件. 溢出文件由 mkstemp 创建, 名称在各实例间
+    // 唯一, 创建后立即删除目录项, 只通过文件描述符访问, 进程退出时自动回收
+    bool spill_warm() {
+        if (fd < 0) {
+            std::string path = spill_dir + "/memento_spill_XXXXXX";
+            fd = mkstemp(path.data());
+            if (fd < 0) {
+                return false;
+            }
+            unlink(path.c_str());
+        }
+        Entry& entry = entries[cold_end];
+        ssize_t written = pwrite(fd, entry.packed.data(), entry.packed.size(),
+                                 static_cast<off_t>(file_size));
+        if (written != static_cast<ssize_t>(entry.packed.size())) {
+            return false;
+        }
+        entry.offset = file_size;
+        entry.length = static_cast<std::uint32_t>(entry.packed.size());
+        file_size += entry.length;
+        memory -= entry.length;
+        stat(Tier::Warm).snapshots--;
+        stat(Tier::Warm).bytes -= entry.length;
+        stat(Tier::Cold).snapshots++;
+        stat(Tier::Cold).bytes += entry.length;
+        std::string().swap(entry.packed);
+        ++cold_end;
+        return true;
+    }
+
+    // 映射区域不覆盖请求范围时(文件已增长)重新映射整个文件
+    const char* map_range(std::uint64_t offset, std::size_t length) {
+        if (offset + length > mapped_size) {
+            if (mapped != MAP_FAILED) {
+                munmap(mapped, mapped_size);
+            }
+            mapped_size = static_cast<std::size_t>(file_size);
+            mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                mapped_size = 0;
+                return nullptr;
+            }
+        }
+        return static_cast<const char*>(mapped) + offset;
+    }
+#endif
+
+public:
+    // spill_dir 为溢出文件所在目录, 为空时使用系统临时目录
+    HistoryCareTaker(std::size_t hot_limit, std::size_t memory_budget,
+                     std::string spill_dir = std::string()) :
+        hot_limit(hot_limit ? hot_limit : 1), memory_budget(memory_budget),
+        spill_dir(std::move(spill_dir)) {
+        if (this->spill_dir.empty()) {
+            std::error_code ec;
+            this->spill_dir = std::filesystem::temp_directory_path(ec).string();
+            if (ec) {
+                this->spill_dir = ".";
+            }
+        }
+    }
+
+    HistoryCareTaker(const HistoryCareTaker&) = delete;
+    HistoryCareTaker& operator=(const HistoryCareTaker&) = delete;
+
+    ~HistoryCareTaker() {
+#if MEMENTO_HAS_MMAP
+        if (mapped != MAP_FAILED) {
+            munmap(mapped, mapped_size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    // 保存备忘录, 返回其下标
+    std::size_t set_memento(std::shared_ptr<Originator::Memento> memento) {
+        Entry entry;
+        entry.raw_size = memento->getState().size();
+        entry.memento = std::move(memento);
+        memory += entry.raw_size;
+        stat(Tier::Hot).snapshots++;
+        stat(Tier::Hot).bytes += entry.raw_size;
+        entries.push_back(std::move(entry));
+
+        while (entries.size() - warm_end > hot_limit) {
+            demote_hot();
+        }
+        // 超出预算时先把温快照溢出到磁盘, 仍不够才继续压缩热快照,
+        // 最新的快照总是保持为热快照
+        while (memory > memory_budget) {
+#if MEMENTO_HAS_MMAP
+            if (cold_end < warm_end && spill_warm()) {
+                continue;
+            }
+#endif
+            if (entries.size() - warm_end <= 1) {
+                break;
+            }
+            demote_hot();
+        }
+        return entries.size() - 1;
+    }
+
+    // 获取任意历史快照, 并按所在层级统计命中延迟; 下标越界时返回空指针
+    std::shared_ptr<Originator::Memento> get_memento(std::size_t index) {
+        if (index >= entries.size()) {
+            return nullptr;
+        }
+        auto start = std::chrono::steady_clock::now();
+        Tier tier = tier_of(index);
+        const Entry& entry = entries[index];
+        std::shared_ptr<Originator::Memento> memento;
+        if (tier == Tier::Hot) {
+            memento = entry.memento;
+        } else if (tier == Tier::Warm) {
+            memento = std::make_shared<Originator::Memento>(
+                lz::decompress(entry.packed.data(), entry.packed.size()));
+        } else {
+#if MEMENTO_HAS_MMAP
+            if (const char* data = map_range(entry.offset, entry.length)) {
+                memento = std::make_shared<Originator::Memento>(
+                    lz::decompress(data, entry.length));
+            }
+#endif
+        }
+        TierStats& s = stat(tier);
+        s.hits++;
+        s.hit_ns += std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        return memento;
+    }
+
+    Tier tier_of(std::size_t index) const {
+        if (index < cold_end) {
+            return Tier::Cold;
+        }
+        return index < warm_end ? Tier::Warm : Tier::Hot;
+    }
+
+    std::size_t size() const {
+        return entries.size();
+    }
+
+    // 热 + 温层当前占用的内存字节数
+    std::size_t memory_bytes() const {
+        return memory;
+    }
+
+    void report(std::ostream& os) const {
+        static const char* names[] = { "hot", "warm", "cold" };
+        for (int i = 0; i < 3; ++i) {
+            const TierStats& s = stats[i];
+            os << "  " << names[i] << ": " << s.snapshots << " snapshots, "
+               << s.bytes / 1024 << " KiB, " << s.hits << " hits, "
+               << (s.hits ? s.hit_ns / s.hits / 1000 : 0) << " us/hit"
+               << std::endl;
+        }
+    }
+};
+
+// 异步快照: 调用方只冻结一个持久化版本(复制根指针)并入队, 后台线程负责
+// 序列化与压缩. 冻结的版本不可变, 发起者在序列化期间可以继续修改状态
+class AsyncSnapshotter {
+public:
+    struct Snapshot {
+        std::string data;        // 序列化并压缩后的状态
+        double serialize_ms = 0; // 后台序列化耗时
+    };
+
+private:
+    struct Job {
+        std::shared_ptr<const RopeOriginator::Memento> memento;
+        std::promise<Snapshot> done;
+    };
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Job> jobs;
+    bool stopping = false;
+    std::thread worker;
+
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            // 序列化或压缩失败(如内存不足)时通过 future 交给调用方,
+            // 后台线程继续处理后续快照
+            try {
+                auto start = std::chrono::steady_clock::now();
+                Snapshot snapshot;
+                snapshot.data = lz::compress(job.memento->getState().str());
+                snapshot.serialize_ms =
+                    std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+                job.memento.reset();
+                job.done.set_value(std::move(snapshot));
+            } catch (...) {
+                job.memento.reset();
+                job.done.set_exception(std::current_exception());
+            }
+        }
+    }
+
+public:
+    AsyncSnapshotter() : worker([this] { run(); }) {
+    }
+
+    AsyncSnapshotter(const AsyncSnapshotter&) = delete;
+    AsyncSnapshotter& operator=(const AsyncSnapshotter&) = delete;
+
+    // 处理完已提交的快照后退出
+    ~AsyncSnapshotter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_one();
+        worker.join();
+    }
+
+    // 在调用线程上只做 O(1) 的版本冻结, 序列化结果通过 future 返回
+    std::future<Snapshot> snapshot(const RopeOriginator& originator) {
+        Job job{ originator.create_memento(), {} };
+        std::future<Snapshot> result = job.done.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        ready.notify_one();
+        return result;
+    }
+};
+
+// 对比完整拷贝备忘录与增量备忘录: 在约 4MB 的文档上做若干次小编辑并快照,
+// 统计快照总字节数、快照耗时以及最深差异链的恢复耗时
+void delta_benchmark(std::size_t doc_size, std::size_t snapshots,
+                     std::size_t keyframe_interval) {
+    using clock = std::chrono::steady_clock;
+    std::mt19937 rng(42);
+    std::string doc(doc_size, ' ');
+    for (char& c: doc) {
+        c = static_cast<char>('a' + rng() % 26);
+    }
+
+    // 预先生成编辑后的各个版本, 两种方式快照相同的状态序列
+    std::vector<std::string> versions;
+    versions.reserve(snapshots);
+    for (std::size_t i = 0; i < snapshots; ++i) {
+        std::size_t pos = rng() % doc.size();
+        std::size_t rest = doc.size() - pos;
+        switch (rng() % 3) {
+            case 0:
+                doc.insert(pos, "inserted text #" + std::to_string(i));
+                break;
+            case 1:
+                doc.erase(pos, std::min<std::size_t>(64, rest));
+                break;
+            default:
+                doc.replace(pos, std::min<std::size_t>(16, rest), "REPLACED");
+                break;
+        }
+        versions.push_back(doc);
+    }
+
+    Originator originator;
+    originator.set_keyframe_interval(keyframe_interval);
+
+    std::vector<std::shared_ptr<Originator::Memento>> full;
+    std::size_t full_bytes = 0;
+    auto t0 = clock::now();
+    for (const std::string& v: versions) {
+        originator.set_state(v);
+        full.push_back(originator.create_memento());
+        full_bytes += v.size();
+    }
+    auto t1 = clock::now();
+
+    std::vector<std::shared_ptr<const Originator::DeltaMemento>> deltas;
+    std::size_t delta_bytes = 0;
+    std::size_t keyframes = 0;
+    for (const std::string& v: versions) {
+        originator.set_state(v);
+        deltas.push_back(originator.create_delta_memento());
+        delta_bytes += deltas.back()->size_bytes();
+        keyframes += deltas.back()->is_keyframe() ? 1 : 0;
+    }
+    auto t2 = clock::now();
+
+    // 找到差异链最深的快照, 比较两种方式的恢复耗时并校验结果
+    std::size_t worst = 0;
+    for (std::size_t i = 0; i < deltas.size(); ++i) {
+        if (deltas[i]->get_depth() > deltas[worst]->get_depth()) {
+            worst = i;
+        }
+    }
+    auto t3 = clock::now();
+    originator.restore_memento(full[worst]);
+    auto t4 = clock::now();
+    originator.restore_memento(deltas[worst]);
+    auto t5 = clock::now();
+    bool ok = originator.get_state() == versions[worst];
+    for (std::size_t i = 0; ok && i < deltas.size(); ++i) {
+        ok = deltas[i]->getState() == versions[i];
+    }
+
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    std::cout << "delta mementos: " << snapshots << " snapshots of ~"
+              << doc_size / 1024 << " KiB, keyframe every "
+              << keyframe_interval << " (" << keyframes << " keyframes)"
+              << std::endl
+              << "  full : " << full_bytes / 1024 << " KiB, snapshot "
+              << ms(t1 - t0) << " ms, restore " << ms(t4 - t3) << " ms"
+              << std::endl
+              << "  delta: " << delta_bytes / 1024 << " KiB ("
+              << static_cast<double>(full_bytes) / delta_bytes
+              << "x smaller), snapshot " << ms(t2 - t1) << " ms, restore depth "
+              << deltas[worst]->get_depth() << " " << ms(t5 - t4) << " ms"
+              << std::endl
+              << "  round trip " << (ok ? "ok" : "MISMATCH") << std::endl;
+}
+
+// 持久化快照: 大文档上每次小编辑后保存一个备忘录, 统计创建/恢复耗时,
+// 以及所有备忘录实际占用的内存(共享块只计一次)与完整拷贝的对比
+void rope_benchmark(std::size_t doc_size, std::size_t snapshots) {
+    using clock = std::chrono::steady_clock;
+    std::mt19937 rng(7);
+    std::string text(doc_size, ' ');
+    for (char& c: text) {
+        c = static_cast<char>('a' + rng() % 26);
+    }
+
+    RopeOriginator originator;
+    originator.set_state(text);
+    std::string reference = text; // 用普通字符串同步编辑以校验结果
+
+    std::vector<std::shared_ptr<const RopeOriginator::Memento>> history;
+    history.reserve(snapshots);
+    std::vector<std::string> checks; // 抽样保存若干版本用于校验
+    clock::duration edit_time{};
+    clock::duration create_time{};
+    for (std::size_t i = 0; i < snapshots; ++i) {
+        std::size_t pos = rng() % originator.size();
+        std::size_t rest = originator.size() - pos;
+        std::size_t erased = std::min<std::size_t>(8, rest);
+        std::size_t replaced = std::min<std::size_t>(4, rest);
+        std::size_t kind = rng() % 3;
+        std::string label = "edit #" + std::to_string(i);
+        auto t0 = clock::now();
+        switch (kind) {
+            case 0:
+                originator.insert(pos, label);
+                break;
+            case 1:
+                originator.erase(pos, erased);
+                break;
+            default:
+                originator.replace(pos, replaced, "XY");
+                break;
+        }
+        auto t1 = clock::now();
+        history.push_back(originator.create_memento());
+        auto t2 = clock::now();
+        edit_time += t1 - t0;
+        create_time += t2 - t1;
+        switch (kind) {
+            case 0:
+                reference.insert(pos, label);
+                break;
+            case 1:
+                reference.erase(pos, erased);
+                break;
+            default:
+                reference.replace(pos, replaced, "XY");
+                break;
+        }
+        if (i % (snapshots / 4) == 0) {
+            checks.push_back(reference);
+        }
+    }
+
+    auto t3 = clock::now();
+    for (std::size_t i = 0; i < history.size(); ++i) {
+        originator.restore_memento(history[history.size() - 1 - i]);
+    }
+    auto t4 = clock::now();
+
+    bool ok = originator.get_state() == checks.front();
+    for (std::size_t i = 0; ok && i < checks.size(); ++i) {
+        ok = history[i * (snapshots / 4)]->getState().str() == checks[i];
+    }
+
+    std::unordered_set<const cow::Node*> seen;
+    std::size_t shared = 0;
+    for (const auto& memento: history) {
+        shared += cow::unique_bytes(memento->getState().tree(), seen);
+    }
+
+    auto ns = [&](clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() /
+               static_cast<double>(snapshots);
+    };
+    std::cout << "rope mementos: " << snapshots << " snapshots of ~"
+              << doc_size / 1024 << " KiB" << std::endl
+              << "  edit " << ns(edit_time) << " ns, create "
+              << ns(create_time) << " ns, restore " << ns(t4 - t3)
+              << " ns per op" << std::endl
+              << "  memory: " << shared / 1024 << " KiB shared vs "
+              << snapshots * doc_size / 1024 << " KiB for full copies"
+              << ", round trip " << (ok ? "ok" : "MISMATCH") << std::endl;
+}
+
+// 分层历史: 生成可压缩的文本状态并逐次小改后保存, 随机回看历史快照,
+// 统计每个层级的快照数、占用与命中延迟
+void history_tier_benchmark(std::size_t state_size, std::size_t snapshots,
+                            std::size_t hot_limit, std::size_t budget) {
+    static const char* words[] = { "memento", "originator", "caretaker",
+                                   "state",   "snapshot",   "restore",
+                                   "undo",    "history",    "document" };
+    std::mt19937 rng(11);
+    std::string text;
+    while (text.size() < state_size) {
+        text += words[rng() % 9];
+        text += rng() % 8 ? ' ' : '\n';
+    }
+
+    Originator originator;
+    HistoryCareTaker care_taker(hot_limit, budget);
+    std::vector<std::size_t> checksums;
+    std::size_t raw_bytes = 0;
+    for (std::size_t i = 0; i < snapshots; ++i) {
+        text.replace(rng() % (text.size() - 16), 16, words[rng() % 9]);
+        text += " v" + std::to_string(i);
+        originator.set_state(text);
+        care_taker.set_memento(originator.create_memento());
+        checksums.push_back(std::hash<std::string>()(text));
+        raw_bytes += text.size();
+    }
+
+    bool ok = true;
+    for (std::size_t i = 0; i < snapshots * 4; ++i) {
+        std::size_t index = rng() % snapshots;
+        auto memento = care_taker.get_memento(index);
+        ok = ok && memento &&
+             std::hash<std::string>()(memento->getState()) == checksums[index];
+    }
+
+    std::cout << "history tiers: " << snapshots << " snapshots, "
+              << raw_bytes / 1024 << " KiB raw, "
+              << care_taker.memory_bytes() / 1024 << " KiB in memory (budget "
+              << budget / 1024 << " KiB), round trip "
+              << (ok ? "ok" : "MISMATCH") << std::endl;
+    care_taker.report(std::cout);
+}
+
+// 异步快照: 持续编辑大文档, 周期性请求快照, 对比同步序列化与异步快照时
+// 调用方感受到的停顿, 并统计序列化期间继续完成的编辑数
+void async_snapshot_benchmark(std::size_t doc_size, std::size_t rounds,
+                              std::size_t edits_per_round) {
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    std::mt19937 rng(3);
+    std::string text;
+    while (text.size() < doc_size) {
+        text += "snapshot state " + std::to_string(rng() % 1000) + '\n';
+    }
+
+    RopeOriginator originator;
+    originator.set_state(text);
+    auto edit = [&](std::size_t i) {
+        originator.replace(rng() % (originator.size() - 8), 8,
+                           "edit " + std::to_string(i));
+    };
+
+    // 同步: 调用方自己完成序列化
+    double sync_pause = 0;
+    double sync_max = 0;
+    for (std::size_t r = 0; r < rounds; ++r) {
+        for (std::size_t i = 0; i < edits_per_round; ++i) {
+            edit(i);
+        }
+        auto t0 = clock::now();
+        std::string data = lz::compress(originator.get_state());
+        double pause = ms(clock::now() - t0);
+        sync_pause += pause;
+        sync_max = std::max(sync_max, pause);
+    }
+
+    // 异步: 调用方只冻结版本, 随即继续编辑
+    double async_pause = 0;
+    double async_max = 0;
+    double serialize = 0;
+    std::size_t overlapped = 0; // 后台仍有快照未完成时进行的编辑
+    bool ok = true;
+    {
+        AsyncSnapshotter snapshotter;
+        std::deque<std::future<AsyncSnapshotter::Snapshot>> pending;
+        auto collect = [&](bool wait) {
+            while (!pending.empty() &&
+                   (wait || pending.front().wait_for(std::chrono::seconds(
+                                0)) == std::future_status::ready)) {
+                serialize += pending.front().get().serialize_ms;
+                pending.pop_front();
+            }
+        };
+        // 抽查第一份快照的内容
+        std::string expected = originator.get_state();
+        auto first = snapshotter.snapshot(originator);
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (std::size_t i = 0; i < edits_per_round; ++i) {
+                edit(i);
+                overlapped += pending.empty() ? 0 : 1;
+            }
+            collect(false); // 调用方从不等待后台序列化
+            auto t0 = clock::now();
+            pending.push_back(snapshotter.snapshot(originator));
+            double pause = ms(clock::now() - t0);
+            async_pause += pause;
+            async_max = std::max(async_max, pause);
+        }
+        collect(true);
+        AsyncSnapshotter::Snapshot snapshot = first.get();
+        ok = lz::decompress(snapshot.data.data(), snapshot.data.size()) ==
+             expected;
+    }
+
+    std::cout << "async snapshots: " << rounds << " snapshots of ~"
+              << doc_size / 1024 << " KiB" << std::endl
+              << "  sync  pause avg " << sync_pause / rounds << " ms, max "
+              << sync_max << " ms" << std::endl
+              << "  async pause avg " << async_pause / rounds << " ms, max "
+              << async_max << " ms; background serialize avg "
+              << serialize / rounds << " ms, " << overlapped
+              << " edits overlapped, snapshot "
+              << (ok ? "ok" : "MISMATCH") << std::endl;
+}
+
 int main(int argc, char* argv[]) {
 
     // 设置初始状态
@@ -159,5 +1486,55 @@ int main(int argc, char* argv[]) {
     originator.restore_memento(care_taker.get_memento());
     originator.show_state();
 
+    // 增量备忘录: 相邻快照之间只保存差异
+    originator.set_state("The quick brown fox jumps over the lazy dog.");
+    auto v1 = originator.create_delta_memento();
+    originator.set_state("The quick brown fox jumps over the sleepy dog.");
+    auto v2 = originator.create_delta_memento();
+    std::cout << "delta memento: " << v2->size_bytes() << " bytes vs "
+              << v1->size_bytes() << " bytes keyframe" << std::endl;
+    originator.restore_memento(v1);
+    originator.show_state();
+    originator.restore_memento(v2);
+    originator.show_state();
+
+    delta_benchmark(4 << 20, 50, 16);
+
+    // 持久化快照: 备忘录与当前状态共享未修改的块
+    RopeOriginator document;
+    document.set_state("The quick brown fox jumps over the lazy dog.");
+    auto before = document.create_memento();
+    document.replace(35, 4, "sleepy");
+    std::cout << "rope memento: " << before->getState().str() << " -> "
+              << document.get_state() << std::endl;
+    document.restore_memento(before);
+    std::cout << "rope restored: " << document.get_state() << std::endl;
+
+    rope_benchmark(4 << 20, 10000);
+
+    // 分层历史: 保存大量快照, 旧快照压缩或溢出到磁盘
+    HistoryCareTaker history(2, 1 << 10);
+    for (const char* state: { "Draft", "Review", "Approved", "Published" }) {
+        originator.set_state(state);
+        history.set_memento(originator.create_memento());
+    }
+    originator.restore_memento(history.get_memento(0));
+    originator.show_state();
+
+    history_tier_benchmark(256 << 10, 200, 8, 8 << 20);
+
+    // 异步快照: 冻结当前版本后立即返回, 序列化在后台完成
+    {
+        AsyncSnapshotter snapshotter;
+        auto pending = snapshotter.snapshot(document);
+        document.insert(0, "Edited: ");
+        AsyncSnapshotter::Snapshot snapshot = pending.get();
+        std::cout << "async snapshot: "
+                  << lz::decompress(snapshot.data.data(), snapshot.data.size())
+                  << " (now: " << document.get_state() << ")" << std::endl;
+    }
+
+    async_snapshot_benchmark(16 << 20, 20, 2000);
+
     return 0;
 }